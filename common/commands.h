@@ -15,11 +15,14 @@ namespace commands::protocols {
     class In : public pack::Node
     {
     public:
-        pack::String address = FIELD("address");
+        pack::String address     = FIELD("address");
+        pack::UInt32 timeout     = FIELD("timeout", 5000);        // overall timeout of all probes in milliseconds
+        pack::String community   = FIELD("community", "public"); // community used by SNMP v1/v2c probe
+        pack::Bool   bypassCache = FIELD("bypass_cache");        // probe device even if result is cached
 
     public:
         using pack::Node::Node;
-        META(In, address);
+        META(In, address, timeout, community, bypassCache);
     };
 
     using Out = pack::StringList;
@@ -39,10 +42,11 @@ namespace commands::mibs {
         pack::String credentialId = FIELD("secw_credential_id");
         pack::String community    = FIELD("community");
         pack::UInt32 timeout      = FIELD("timeout", 1000); // timeout in milliseconds
+        pack::Bool   bypassCache  = FIELD("bypass_cache");  // read device even if result is cached
 
     public:
         using pack::Node::Node;
-        META(In, address, port, credentialId, community, timeout);
+        META(In, address, port, credentialId, community, timeout, bypassCache);
     };
 
     using Out = pack::StringList;
@@ -71,14 +75,15 @@ namespace commands::assets {
         };
 
     public:
-        pack::String address  = FIELD("address");
-        pack::String protocol = FIELD("protocol");
-        pack::UInt32 port     = FIELD("port");
-        Settings     settings = FIELD("protocol_settings");
+        pack::String address     = FIELD("address");
+        pack::String protocol    = FIELD("protocol");
+        pack::UInt32 port        = FIELD("port");
+        Settings     settings    = FIELD("protocol_settings");
+        pack::Bool   bypassCache = FIELD("bypass_cache"); // read device even if result is cached
 
     public:
         using pack::Node::Node;
-        META(In, address, protocol, port, settings);
+        META(In, address, protocol, port, settings, bypassCache);
     };
 
     class Return : public pack::Node
@@ -111,4 +116,100 @@ namespace commands::assets {
 
 // =====================================================================================================================
 
+namespace commands::scan {
+    static constexpr const char* Subject = "scan";
+
+    /// Every scanned host is published on this topic as soon as it is probed (correlation id of the request is kept)
+    static constexpr const char* Topic = "discovery-scan";
+
+    class In : public pack::Node
+    {
+    public:
+        pack::StringList ranges      = FIELD("ranges");      // addresses, CIDR blocks or ranges (10.0.0.1-10.0.0.20)
+        pack::UInt32     concurrency = FIELD("concurrency"); // max parallel probes, default is taken from config
+
+    public:
+        using pack::Node::Node;
+        META(In, ranges, concurrency);
+    };
+
+    class Result : public pack::Node
+    {
+    public:
+        pack::String     address   = FIELD("address");
+        pack::StringList protocols = FIELD("protocols");
+        pack::String     error     = FIELD("error");
+
+    public:
+        using pack::Node::Node;
+        META(Result, address, protocols, error);
+    };
+
+    /// List of hosts which support at least one protocol
+    using Out = pack::ObjectList<Result>;
+} // namespace commands::scan
+
+// =====================================================================================================================
+
+namespace commands::cache {
+    /// Drops cached results of protocols, mibs and assets requests, and reachability of hosts
+    static constexpr const char* Subject = "cache/invalidate";
+
+    class In : public pack::Node
+    {
+    public:
+        pack::String address = FIELD("address"); // drops results of this address only, all results if empty
+
+    public:
+        using pack::Node::Node;
+        META(In, address);
+    };
+
+    class Out : public pack::Node
+    {
+    public:
+        pack::UInt32 removed = FIELD("removed"); // number of dropped results
+
+    public:
+        using pack::Node::Node;
+        META(Out, removed);
+    };
+} // namespace commands::cache
+
+// =====================================================================================================================
+
+namespace commands::drivers {
+    /// Statistics of NUT drivers runs
+    static constexpr const char* Subject = "drivers/stats";
+
+    class In : public pack::Node
+    {
+    public:
+        pack::String driver = FIELD("driver"); // statistics of this driver only, all drivers if empty
+
+    public:
+        using pack::Node::Node;
+        META(In, driver);
+    };
+
+    class Stat : public pack::Node
+    {
+    public:
+        pack::String driver   = FIELD("driver");
+        pack::String path     = FIELD("path");
+        pack::UInt32 running  = FIELD("running");   // number of currently running instances
+        pack::UInt32 spawns   = FIELD("spawns");    // number of runs
+        pack::UInt32 spawnAvg = FIELD("spawn_avg"); // average spawn latency in microseconds
+        pack::UInt32 spawnMax = FIELD("spawn_max"); // max spawn latency in microseconds
+
+    public:
+        using pack::Node::Node;
+        META(Stat, driver, path, running, spawns, spawnAvg, spawnMax);
+    };
+
+    using Out = pack::ObjectList<Stat>;
+} // namespace commands::drivers
+
+// =====================================================================================================================
+
 } // namespace fty
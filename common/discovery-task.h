@@ -2,9 +2,18 @@
 #include "commands.h"
 #include "message-bus.h"
 #include "message.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fty/expected.h>
 #include <fty/thread-pool.h>
 #include <fty_log.h>
+#include <functional>
+#include <type_traits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace fty::job {
 
@@ -78,29 +87,184 @@ public:
 
 // =====================================================================================================================
 
+/// Requests waiting for identical in-flight tasks.
+/// The first request with some key runs the task, all requests joined until it finishes get the same response.
+class InFlight
+{
+public:
+    static InFlight& instance()
+    {
+        static InFlight inst;
+        return inst;
+    }
+
+    /// Registers request, returns false if identical task is already running and request just waits for its response
+    bool join(const std::string& key, const disco::Message& msg)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto it = m_waiters.find(key); it != m_waiters.end()) {
+            it->second.push_back(msg);
+            return false;
+        }
+        m_waiters.emplace(key, std::vector<disco::Message>{});
+        return true;
+    }
+
+    /// Finishes task, returns requests which joined it
+    std::vector<disco::Message> done(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<disco::Message> waiters;
+        if (auto it = m_waiters.find(key); it != m_waiters.end()) {
+            waiters = std::move(it->second);
+            m_waiters.erase(it);
+        }
+        return waiters;
+    }
+
+private:
+    std::mutex                                         m_mutex;
+    std::map<std::string, std::vector<disco::Message>> m_waiters;
+};
+
+// =====================================================================================================================
+
+/// Sends response to the request and to all identical requests which joined it
+template <typename ResponseT>
+void answer(disco::MessageBus& bus, const disco::Message& in, const std::string& key, Response<ResponseT>& response)
+{
+    disco::Message answ = response;
+    if (auto res = bus.reply(fty::Channel, in, answ); !res) {
+        log_error(res.error().c_str());
+    }
+    if (key.empty()) {
+        return;
+    }
+    for (const auto& waiter : InFlight::instance().done(key)) {
+        if (auto res = bus.reply(fty::Channel, waiter, answ); !res) {
+            log_error(res.error().c_str());
+        }
+    }
+}
+
+// =====================================================================================================================
+
+template <typename T, typename = void>
+struct HasAddress : std::false_type
+{
+};
+
+template <typename T>
+struct HasAddress<T, std::void_t<decltype(std::declval<T>().address)>> : std::true_type
+{
+};
+
+/// Common part of blocking and asynchronous tasks: request decoding, deadline and coalescing
 template <typename T, typename InputT, typename ResponseT>
-class Task : public fty::Task<T>
+class BasicTask : public fty::Task<T>
 {
 public:
-    Task(const disco::Message& in, disco::MessageBus& bus)
+    using Clock = std::chrono::steady_clock;
+
+    BasicTask(const disco::Message& in, disco::MessageBus& bus)
         : m_in(in)
         , m_bus(&bus)
     {
     }
 
+    /// Sets time when requester stops waiting for the answer
+    void setDeadline(Clock::time_point deadline)
+    {
+        m_deadline = deadline;
+    }
+
+    /// Sets function called once the task is finished and answered (asynchronous task can finish after it returns)
+    void setDone(std::function<void()>&& done)
+    {
+        m_done = std::move(done);
+    }
+
+protected:
+    /// Decodes request, returns false if there is nothing to answer: requester does not wait anymore or identical
+    /// request is already running. Throws if request is wrong.
+    bool prepare(InputT& cmd, std::string& key)
+    {
+        if (Clock::now() >= m_deadline) {
+            log_info("Skip %s request, requester does not wait for it anymore", m_in.meta.subject.value().c_str());
+            return false;
+        }
+
+        if (m_in.userData.empty()) {
+            throw Error("Wrong input data: payload is empty");
+        }
+
+        if (auto parsedCmd = m_in.userData.decode<InputT>()) {
+            cmd = *parsedCmd;
+        } else {
+            throw Error("Wrong input data: format of payload is incorrect");
+        }
+
+        // Requests are identical only if whole payloads are, a hash could mix up two of them. Payload carries
+        // communities and passwords, so the key is never logged.
+        key = m_in.meta.subject.value() + "\n" + *pack::json::serialize(cmd);
+        if (!InFlight::instance().join(key, m_in)) {
+            log_debug("Join running %s task for %s", m_in.meta.subject.value().c_str(), target(cmd).c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /// Address the request is about, empty if it has none
+    template <typename CmdT>
+    static std::string target(const CmdT& cmd)
+    {
+        if constexpr (HasAddress<CmdT>::value) {
+            return cmd.address.value();
+        } else {
+            return {};
+        }
+    }
+
+    /// Returns timeout cut down to the time left till the deadline, throws if there is no time left
+    std::chrono::milliseconds budget(std::chrono::milliseconds timeout = std::chrono::milliseconds::max()) const
+    {
+        if (m_deadline == Clock::time_point::max()) {
+            return timeout;
+        }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(m_deadline - Clock::now());
+        if (left.count() <= 0) {
+            throw Error("Request timed out");
+        }
+        return std::min(timeout, left);
+    }
+
+protected:
+    disco::Message        m_in;
+    disco::MessageBus*    m_bus;
+    Clock::time_point     m_deadline = Clock::time_point::max();
+    std::function<void()> m_done;
+};
+
+// =====================================================================================================================
+
+/// Task which runs on a worker thread until the response is ready
+template <typename T, typename InputT, typename ResponseT>
+class Task : public BasicTask<T, InputT, ResponseT>
+{
+public:
+    Task(const disco::Message& in, disco::MessageBus& bus)
+        : BasicTask<T, InputT, ResponseT>(in, bus)
+    {
+    }
+
     void operator()() override
     {
         Response<ResponseT> response;
+        std::string         key;
         try {
-            if (m_in.userData.empty()) {
-                throw Error("Wrong input data: payload is empty");
-            }
-
             InputT cmd;
-            if (auto parsedCmd = m_in.userData.decode<InputT>()) {
-                cmd = *parsedCmd;
-            } else {
-                throw Error("Wrong input data: format of payload is incorrect");
+            if (!this->prepare(cmd, key)) {
+                return;
             }
 
             if (auto it = dynamic_cast<T*>(this)) {
@@ -110,21 +274,119 @@ public:
             }
 
             response.status = disco::Message::Status::Ok;
-            if (auto res = m_bus->reply(fty::Channel, m_in, response); !res) {
-                log_error(res.error().c_str());
-            }
         } catch (const Error& err) {
             log_error("Error: %s", err.what());
             response.setError(err.what());
-            if (auto res = m_bus->reply(fty::Channel, m_in, response); !res) {
-                log_error(res.error().c_str());
+        } catch (const std::exception& err) {
+            log_error("Error: %s", err.what());
+            response.setError(err.what());
+        }
+
+        answer(*this->m_bus, this->m_in, key, response);
+    }
+
+    static constexpr bool Async = false;
+};
+
+// =====================================================================================================================
+
+/// Completion of asynchronous task, can be called from any thread, only the first answer is sent
+template <typename ResponseT>
+class Reply
+{
+public:
+    Reply(const disco::Message& in, disco::MessageBus& bus, std::function<void()> done = {})
+        : m_state(std::make_shared<State>())
+    {
+        m_state->in   = in;
+        m_state->bus  = &bus;
+        m_state->done = std::move(done);
+    }
+
+    /// Identical requests joined under the key get the same answer
+    void setKey(const std::string& key)
+    {
+        m_state->key = key;
+    }
+
+    /// Sends result
+    void operator()(const ResponseT& out) const
+    {
+        if (m_state->sent.exchange(true)) {
+            return;
+        }
+        Response<ResponseT> response;
+        response.out    = out;
+        response.status = disco::Message::Status::Ok;
+        answer(*m_state->bus, m_state->in, m_state->key, response);
+        if (m_state->done) {
+            m_state->done();
+        }
+    }
+
+    /// Sends error
+    void fail(const std::string& error) const
+    {
+        if (m_state->sent.exchange(true)) {
+            return;
+        }
+        log_error("Error: %s", error.c_str());
+        Response<ResponseT> response;
+        response.setError(error);
+        answer(*m_state->bus, m_state->in, m_state->key, response);
+        if (m_state->done) {
+            m_state->done();
+        }
+    }
+
+private:
+    struct State
+    {
+        disco::Message        in;
+        disco::MessageBus*    bus = nullptr;
+        std::string           key;
+        std::function<void()> done;
+        std::atomic_bool      sent = false;
+    };
+    std::shared_ptr<State> m_state;
+};
+
+/// Task which only starts the work on a worker thread, job sends requests and keeps the reply in their callbacks, so
+/// the worker is free while the device answers. Job must not block in callbacks.
+template <typename T, typename InputT, typename ResponseT>
+class AsyncTask : public BasicTask<T, InputT, ResponseT>
+{
+public:
+    AsyncTask(const disco::Message& in, disco::MessageBus& bus)
+        : BasicTask<T, InputT, ResponseT>(in, bus)
+    {
+    }
+
+    void operator()() override
+    {
+        Reply<ResponseT> reply(this->m_in, *this->m_bus, this->m_done);
+        try {
+            InputT      cmd;
+            std::string key;
+            if (!this->prepare(cmd, key)) {
+                if (this->m_done) {
+                    this->m_done();
+                }
+                return;
+            }
+            reply.setKey(key);
+
+            if (auto it = dynamic_cast<T*>(this)) {
+                it->run(cmd, reply);
+            } else {
+                throw Error("Not a correct task");
             }
+        } catch (const std::exception& err) {
+            reply.fail(err.what());
         }
     }
 
-protected:
-    disco::Message     m_in;
-    disco::MessageBus* m_bus;
+    static constexpr bool Async = true;
 };
 
 } // namespace fty::job
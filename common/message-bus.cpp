@@ -95,6 +95,19 @@ Expected<Message> MessageBus::recieve(const std::string& queue)
     }
 }
 
+Expected<void> MessageBus::publish(const std::string& topic, const Message& msg)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    msg.meta.from = m_actorName;
+    try {
+        m_bus->publish(topic, msg.toMessageBus());
+        return {};
+    } catch (messagebus::MessageBusException& ex) {
+        return unexpected(ex.what());
+    }
+}
+
 Expected<void> MessageBus::subsribe(const std::string& queue, std::function<void(const messagebus::Message&)>&& func)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
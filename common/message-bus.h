@@ -51,6 +51,7 @@ public:
     [[nodiscard]] Expected<Message> send(const std::string& queue, const Message& msg);
     [[nodiscard]] Expected<void>    reply(const std::string& queue, const Message& req, const Message& answ);
     [[nodiscard]] Expected<Message> recieve(const std::string& queue);
+    [[nodiscard]] Expected<void>    publish(const std::string& topic, const Message& msg);
 
     template <typename Func, typename Cls>
     [[nodiscard]] Expected<void> subsribe(const std::string& queue, Func&& fnc, Cls* cls)
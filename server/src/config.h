@@ -32,9 +32,54 @@ public:
     pack::String mibDatabase = FIELD("mib-database", "mibs");
     pack::Bool   tryAll      = FIELD("try-all", false);
 
+    pack::String nutInventory = FIELD("nut-inventory", "nut/inventory.yaml"); // inventory part of NUT mib2nut tables
+
+    // NUT drivers: concurrent runs of each driver, limits of one run (0 is unlimited)
+    pack::UInt32 driverJobs    = FIELD("driver-jobs", 4);
+    pack::UInt32 driverTimeout = FIELD("driver-timeout", 60); // wall time in seconds
+    pack::UInt32 driverCpu     = FIELD("driver-cpu", 30);     // cpu time in seconds
+    pack::UInt32 driverMemory  = FIELD("driver-memory", 512); // address space in MiB
+
+    pack::UInt32 scanConcurrency = FIELD("scan-concurrency", 64);
+    pack::UInt32 scanMaxHosts    = FIELD("scan-max-hosts", 4096);
+
+    // Protocol probes of all requests and scans (3 per host): threads, max number of waiting probes
+    pack::UInt32 probeThreads = FIELD("probe-threads", 192);
+    pack::UInt32 probeQueue   = FIELD("probe-queue", 1024);
+
+    pack::UInt32 reachabilityTimeout  = FIELD("reachability-timeout", 1000); // timeout in milliseconds
+    pack::UInt32 reachabilityCacheTtl = FIELD("reachability-cache-ttl", 30); // time to live in seconds
+    pack::UInt32 resolverThreads      = FIELD("resolver-threads", 4);
+
+    pack::UInt32 snmpPoolSize = FIELD("snmp-pool-size", 64); // max number of idle SNMP sessions
+    pack::UInt32 snmpPoolIdle = FIELD("snmp-pool-idle", 60); // idle SNMP session lifetime in seconds
+
+    pack::UInt32 walletCacheTtl = FIELD("wallet-cache-ttl", 60); // credentials time to live in seconds
+    pack::UInt32 resultCacheTtl = FIELD("result-cache-ttl", 60); // discovery results time to live in seconds
+
+    pack::UInt32 workers = FIELD("workers", 16); // number of job workers
+
+    // Job queues: share of workers, max number of running and waiting jobs
+    pack::UInt32 protocolsWeight      = FIELD("protocols-weight", 8);
+    pack::UInt32 protocolsConcurrency = FIELD("protocols-concurrency", 8);
+    pack::UInt32 protocolsQueue       = FIELD("protocols-queue", 256);
+    pack::UInt32 mibsWeight           = FIELD("mibs-weight", 4);
+    pack::UInt32 mibsConcurrency      = FIELD("mibs-concurrency", 4);
+    pack::UInt32 mibsQueue            = FIELD("mibs-queue", 128);
+    pack::UInt32 assetsWeight         = FIELD("assets-weight", 2);
+    pack::UInt32 assetsConcurrency    = FIELD("assets-concurrency", 4);
+    pack::UInt32 assetsQueue          = FIELD("assets-queue", 64);
+    pack::UInt32 scanWeight           = FIELD("scan-weight", 1);
+    pack::UInt32 scanJobs             = FIELD("scan-jobs", 1); // concurrent scans, each runs scan-concurrency probes
+    pack::UInt32 scanQueue            = FIELD("scan-queue", 4);
+
 public:
     using pack::Node::Node;
-    META(Config, actorName, logConfig, mibDatabase, tryAll);
+    META(Config, actorName, logConfig, mibDatabase, tryAll, nutInventory, driverJobs, driverTimeout, driverCpu,
+        driverMemory, scanConcurrency, scanMaxHosts, probeThreads, probeQueue, reachabilityTimeout,
+        reachabilityCacheTtl, resolverThreads, snmpPoolSize, snmpPoolIdle, walletCacheTtl, resultCacheTtl, workers,
+        protocolsWeight, protocolsConcurrency, protocolsQueue, mibsWeight, mibsConcurrency, mibsQueue, assetsWeight,
+        assetsConcurrency, assetsQueue, scanWeight, scanJobs, scanQueue);
 
 public:
     static Config& instance();
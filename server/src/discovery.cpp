@@ -24,13 +24,21 @@
 #include "config.h"
 #include "daemon.h"
 #include "jobs/assets.h"
+#include "jobs/cache.h"
+#include "jobs/drivers.h"
+#include "jobs/impl/nut/drivers.h"
+#include "jobs/impl/wallet.h"
 #include "jobs/mibs.h"
 #include "jobs/protocols.h"
-#include <fty/thread-pool.h>
+#include "jobs/scan.h"
+#include <cstdlib>
 #include <fty_log.h>
 
 namespace fty {
 
+/// Cache invalidation and driver stats: one running at a time, a few waiting
+static const Scheduler::Limits ControlLimits = {1, 1, 16};
+
 Discovery::Discovery(const std::string& config)
     : m_configPath(config)
 {
@@ -55,6 +63,28 @@ bool Discovery::loadConfig()
 Expected<void> Discovery::init()
 {
     if (auto res = m_bus.init(Config::instance().actorName)) {
+        const auto& conf = Config::instance();
+        m_scheduler.addQueue(commands::protocols::Subject,
+            {conf.protocolsWeight.value(), conf.protocolsConcurrency.value(), conf.protocolsQueue.value()});
+        m_scheduler.addQueue(
+            commands::mibs::Subject, {conf.mibsWeight.value(), conf.mibsConcurrency.value(), conf.mibsQueue.value()});
+        m_scheduler.addQueue(commands::assets::Subject,
+            {conf.assetsWeight.value(), conf.assetsConcurrency.value(), conf.assetsQueue.value()});
+        m_scheduler.addQueue(
+            commands::scan::Subject, {conf.scanWeight.value(), conf.scanJobs.value(), conf.scanQueue.value()});
+        // Control requests only read or drop in-memory state and return at once, their queues are not tuned by config
+        m_scheduler.addQueue(commands::cache::Subject, ControlLimits);
+        m_scheduler.addQueue(commands::drivers::Subject, ControlLimits);
+        m_scheduler.start(conf.workers.value());
+
+        // Driver executables are resolved before the first assets request
+        impl::nut::Drivers::instance();
+
+        // Without notifications cached credentials are still refreshed when they expire
+        if (auto sub = impl::Wallet::instance().subscribe(conf.actorName); !sub) {
+            log_warning("Wallet notifications are not available: %s", sub.error().c_str());
+        }
+
         if (auto sub = m_bus.subsribe(fty::Channel, &Discovery::discover, this)) {
             return {};
         } else {
@@ -68,7 +98,7 @@ Expected<void> Discovery::init()
 void Discovery::shutdown()
 {
     stop();
-    m_pool.stop();
+    m_scheduler.stop();
 }
 
 int Discovery::run()
@@ -82,11 +112,57 @@ void Discovery::discover(const disco::Message& msg)
     log_debug("Discovery: got message %s", msg.dump().c_str());
     log_debug("Payload: %s", msg.userData.asString().c_str());
     if (msg.meta.subject == commands::protocols::Subject) {
-        m_pool.pushWorker<job::Protocols>(msg, m_bus);
+        schedule<job::Protocols>(msg);
     } else if (msg.meta.subject == commands::mibs::Subject) {
-        m_pool.pushWorker<job::Mibs>(msg, m_bus);
+        schedule<job::Mibs>(msg);
     } else if (msg.meta.subject == commands::assets::Subject) {
-        m_pool.pushWorker<job::Assets>(msg, m_bus);
+        schedule<job::Assets>(msg);
+    } else if (msg.meta.subject == commands::scan::Subject) {
+        schedule<job::Scan>(msg);
+    } else if (msg.meta.subject == commands::cache::Subject) {
+        schedule<job::Cache>(msg);
+    } else if (msg.meta.subject == commands::drivers::Subject) {
+        schedule<job::Drivers>(msg);
+    }
+}
+
+template <typename T>
+void Discovery::schedule(const disco::Message& msg)
+{
+    auto reject = [this, msg](const std::string& error) {
+        log_error("Error: %s", error.c_str());
+        job::Response<pack::String> response;
+        response.setError(error);
+        if (auto res = m_bus.reply(fty::Channel, msg, response); !res) {
+            log_error(res.error().c_str());
+        }
+    };
+
+    auto task = std::make_shared<T>(msg, m_bus);
+
+    Scheduler::Job job;
+    if constexpr (T::Async) {
+        // Asynchronous job holds its place in the queue limit until it answers, not only while it sends requests
+        job.start = [task](Scheduler::Done&& done) {
+            task->setDone(std::move(done));
+            (*task)();
+        };
+    } else {
+        job.run = [task]() {
+            (*task)();
+        };
+    }
+    job.expired = [reject]() {
+        reject("Request timed out in queue");
+    };
+    // Requester stops waiting for the answer after timeout (in seconds) since now, no reason to work on it later
+    if (auto timeout = std::strtoul(msg.meta.timeout.value().c_str(), nullptr, 10)) {
+        job.deadline = Scheduler::Clock::now() + std::chrono::seconds(timeout);
+        task->setDeadline(job.deadline);
+    }
+
+    if (auto res = m_scheduler.push(msg.meta.subject.value(), std::move(job)); !res) {
+        reject(res.error());
     }
 }
 
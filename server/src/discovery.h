@@ -21,8 +21,8 @@
 
 #pragma once
 #include "message-bus.h"
+#include "scheduler.h"
 #include <fty/event.h>
-#include <fty/thread-pool.h>
 #include <string>
 
 namespace fty {
@@ -50,12 +50,15 @@ public:
 
 private:
     void discover(const disco::Message& msg);
+
+    template <typename T>
+    void schedule(const disco::Message& msg);
     void doStop();
 
 private:
     std::string       m_configPath;
     disco::MessageBus m_bus;
-    ThreadPool        m_pool;
+    Scheduler         m_scheduler;
 
     Slot<>                      m_stopSlot       = {&Discovery::doStop, this};
     Slot<>                      m_loadConfigSlot = {&Discovery::loadConfig, this};
@@ -16,16 +16,29 @@
 
 #include "assets.h"
 #include "impl/mibs.h"
+#include "impl/nut/dump.h"
+#include "impl/nut/inventory.h"
 #include "impl/nut/mapper.h"
 #include "impl/nut/process.h"
 #include "impl/ping.h"
+#include "impl/result-cache.h"
+#include "impl/snmp.h"
 #include "impl/uuid.h"
+#include "src/config.h"
+#include <algorithm>
+#include <charconv>
 #include <fty/string-utils.h>
 
 namespace fty::job {
 
 void Assets::run(const commands::assets::In& in, commands::assets::Out& out)
 {
+    auto& cache = impl::ResultCache::instance();
+    if (cache.get(commands::assets::Subject, in, out)) {
+        log_info("Return cached assets for %s", in.address.value().c_str());
+        return;
+    }
+
     if (!available(in.address)) {
         throw Error("Host is not available: {}", in.address.value());
     }
@@ -50,6 +63,11 @@ void Assets::run(const commands::assets::In& in, commands::assets::Out& out)
         } else {
             throw Error("Credential or community must be set");
         }
+        // Request without timeout keeps SNMP default, not the longer default of the field
+        auto timeout = m_params.settings.timeout.hasValue()
+            ? std::chrono::milliseconds(m_params.settings.timeout.value())
+            : impl::snmp::DefaultTimeout;
+        reader.setTimeout(uint32_t(budget(timeout).count()));
 
         if (auto mibs = reader.read(); !mibs) {
             throw Error(mibs.error());
@@ -58,6 +76,17 @@ void Assets::run(const commands::assets::In& in, commands::assets::Out& out)
                 m_params.settings.mib = *mibs->begin();
             }
         }
+
+        // Driver is spawned only for mibs which discovery cannot read by itself
+        if (auto inventory = readInventory(*reader.session())) {
+            impl::nut::Dump dump;
+            dump.parse(*inventory);
+            parse(dump, out);
+            cache.put(commands::assets::Subject, in, out);
+            return;
+        } else {
+            log_debug("Inventory is read by driver: %s", inventory.error().c_str());
+        }
     }
 
     // Runs nut process
@@ -77,44 +106,54 @@ void Assets::run(const commands::assets::In& in, commands::assets::Out& out)
         }
 
         if (m_params.settings.timeout.hasValue()) {
-            proc.setTimeout(m_params.settings.timeout);
+            proc.setTimeout(uint32_t(budget(std::chrono::milliseconds(m_params.settings.timeout.value())).count()));
         }
 
         if (m_params.settings.mib.hasValue()) {
             proc.setMib(m_params.settings.mib);
         }
 
-        if (auto cnt = proc.run()) {
-            parse(*cnt, out);
+        // Dump is parsed while the driver runs. Driver is stopped once the rest of the dump is not needed, the
+        // requester does not wait for the answer anymore or the driver hangs
+        impl::nut::Dump dump;
+        auto            limit = std::chrono::seconds(Config::instance().driverTimeout.value());
+        auto            left  = budget(limit.count() ? limit : std::chrono::milliseconds::max());
+        auto            ms    = left == std::chrono::milliseconds::max() ? -1 : int(left.count());
+        if (auto res = proc.run([&](std::string_view line) { return dump.add(line); }, ms)) {
+            parse(dump, out);
+            cache.put(commands::assets::Subject, in, out);
         } else {
-            throw Error(cnt.error());
+            throw Error(res.error());
         }
     } else {
         throw Error(res.error());
     }
 }
 
-void Assets::parse(const std::string& cnt, commands::assets::Out& out)
+Expected<std::string> Assets::readInventory(const impl::snmp::Session& session) const
 {
-    static std::regex rex("([a-z0-9\\.]+)\\s*:\\s+(.*)");
-
-    std::map<std::string, std::string> tmpMap;
+    auto  mib       = impl::mapMibToLegacy(m_params.settings.mib);
+    auto& inventory = impl::nut::Inventory::instance();
+    if (!inventory.supports(mib)) {
+        return unexpected("mib '{}' is not described by NUT inventory tables", m_params.settings.mib.value());
+    }
 
-    log_debug(cnt.c_str());
+    // Session of the mibs reader is already opened and authenticated, inventory is read by it
+    return inventory.read(session, mib);
+}
 
-    std::stringstream ss(cnt);
-    for (std::string line; std::getline(ss, line);) {
-        auto [key, value] = fty::split<std::string, std::string>(line, rex);
-        tmpMap.emplace(key, value);
-    }
+void Assets::parse(const impl::nut::Dump& dump, commands::assets::Out& out)
+{
+    const auto& values = dump.values();
 
     //Get the device type
-    auto it = tmpMap.find("device.type");
-    std::string deviceType = it != tmpMap.end() ? fty::convert<std::string>(it->second) : "";
-
-    it = tmpMap.find("device.count");
+    std::string deviceType(dump.value("device.type").value_or(""));
 
-    int dcount = it != tmpMap.end() ? fty::convert<int>(it->second) : 0;
+    // Malformed count is read as a single device, as Dump::add does
+    int dcount = 0;
+    if (auto count = dump.value("device.count")) {
+        std::from_chars(count->data(), count->data() + count->size(), dcount);
+    }
     if (dcount > 1) { //daisy chain is always bigger than one
         // daisychain
         for (int i = 0; i < dcount; ++i) {
@@ -123,14 +162,13 @@ void Assets::parse(const std::string& cnt, commands::assets::Out& out)
             asset.asset.type = "device";
             asset.asset.subtype = deviceType;
 
+            // Values are sorted, keys of the device are one run starting at its prefix
             std::string prefix = "device." + std::to_string(i + 1) + ".";
-            for (const auto& p : tmpMap) {
-                if (p.first.find(prefix) != 0) {
-                    continue;
-                }
-
-                if (auto key = impl::nut::Mapper::mapKey(p.first.substr(prefix.size())); !key.empty()) {
-                    addAssetVal(asset.asset, key, p.second);
+            auto        it     = std::lower_bound(
+                values.begin(), values.end(), prefix, [](const auto& val, const auto& pref) { return val.key < pref; });
+            for (; it != values.end() && it->key.compare(0, prefix.size(), prefix) == 0; ++it) {
+                if (auto key = impl::nut::Mapper::mapKey(it->key.substr(prefix.size())); !key.empty()) {
+                    addAssetVal(asset.asset, key, it->value);
                 }
             }
             enrichAsset(asset);
@@ -142,16 +180,17 @@ void Assets::parse(const std::string& cnt, commands::assets::Out& out)
         asset.asset.type = "device";
         asset.asset.subtype = deviceType;
 
-        for (const auto& p : tmpMap) {
-            if (auto key = impl::nut::Mapper::mapKey(p.first); !key.empty()) {
-                addAssetVal(asset.asset, key, p.second);
+        for (const auto& val : values) {
+            if (auto key = impl::nut::Mapper::mapKey(val.key); !key.empty()) {
+                addAssetVal(asset.asset, key, val.value);
             }
         }
         enrichAsset(asset);
     }
 }
 
-void Assets::addAssetVal(commands::assets::Return::Asset& asset, const std::string& key, const std::string& val, bool readOnly)
+void Assets::addAssetVal(
+    commands::assets::Return::Asset& asset, const std::string& key, const std::string& val, bool readOnly)
 {
     auto& ext = asset.ext.append();
     ext.append(key, val);
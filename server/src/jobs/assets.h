@@ -19,6 +19,14 @@
 
 // =====================================================================================================================
 
+namespace fty::impl::nut {
+class Dump;
+}
+
+namespace fty::impl::snmp {
+class Session;
+}
+
 namespace fty::job {
 
 /// Discover Assets from enpoint
@@ -31,8 +39,12 @@ public:
     /// Runs discover job.
     void run(const commands::assets::In& in, commands::assets::Out& out);
 private:
-    void parse(const std::string& cnt, commands::assets::Out& out);
-    void addAssetVal(commands::assets::Return::Asset& asset, const std::string& key, const std::string& val, bool readOnly = true);
+    /// Reads snmp-ups inventory in process, fails if mib is not described by NUT tables or device does not answer
+    Expected<std::string> readInventory(const impl::snmp::Session& session) const;
+
+    void parse(const impl::nut::Dump& dump, commands::assets::Out& out);
+    void addAssetVal(commands::assets::Return::Asset& asset, const std::string& key, const std::string& val,
+        bool readOnly = true);
     void enrichAsset(commands::assets::Return& asset);
 
 private:
@@ -0,0 +1,36 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "cache.h"
+#include "impl/reachability.h"
+#include "impl/result-cache.h"
+#include <fty_log.h>
+
+namespace fty::job {
+
+// =====================================================================================================================
+
+void Cache::run(const commands::cache::In& in, commands::cache::Out& out)
+{
+    out.removed = uint32_t(impl::ResultCache::instance().invalidate(in.address));
+    // Device which was just switched on is not reported as unreachable until its verdict expires
+    impl::Reachability::instance().invalidate(in.address);
+    log_info("Cache: dropped %u results of '%s'", out.removed.value(), in.address.value().c_str());
+}
+
+// =====================================================================================================================
+
+} // namespace fty::job
@@ -0,0 +1,37 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "discovery-task.h"
+
+// =====================================================================================================================
+
+namespace fty::job {
+
+/// Drops cached results of protocols, mibs and assets requests
+/// Returns @ref commands::cache::Out (number of dropped results)
+class Cache : public Task<Cache, commands::cache::In, commands::cache::Out>
+{
+public:
+    using Task::Task;
+
+    /// Runs invalidate job.
+    void run(const commands::cache::In& in, commands::cache::Out& out);
+};
+
+} // namespace fty::job
+
+// =====================================================================================================================
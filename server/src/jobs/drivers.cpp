@@ -0,0 +1,43 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "drivers.h"
+#include "impl/nut/drivers.h"
+
+namespace fty::job {
+
+// =====================================================================================================================
+
+void Drivers::run(const commands::drivers::In& in, commands::drivers::Out& out)
+{
+    for (const auto& stat : impl::nut::Drivers::instance().stats()) {
+        if (in.driver.hasValue() && in.driver.value() != stat.driver) {
+            continue;
+        }
+
+        auto& item    = out.append();
+        item.driver   = stat.driver;
+        item.path     = stat.path;
+        item.running  = stat.running;
+        item.spawns   = stat.spawns;
+        item.spawnAvg = stat.spawns ? uint32_t(stat.spawnTotal.count() / stat.spawns) : 0;
+        item.spawnMax = uint32_t(stat.spawnMax.count());
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::job
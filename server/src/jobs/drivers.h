@@ -0,0 +1,38 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+
+#pragma once
+#include "discovery-task.h"
+
+// =====================================================================================================================
+
+namespace fty::job {
+
+/// Reports statistics of NUT drivers runs
+/// Returns @ref commands::drivers::Out (spawn latency and number of runs of every driver)
+class Drivers : public Task<Drivers, commands::drivers::In, commands::drivers::Out>
+{
+public:
+    using Task::Task;
+
+    /// Runs stats job.
+    void run(const commands::drivers::In& in, commands::drivers::Out& out);
+};
+
+} // namespace fty::job
+
+// =====================================================================================================================
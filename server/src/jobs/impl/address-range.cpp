@@ -0,0 +1,136 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "address-range.h"
+#include <arpa/inet.h>
+#include <set>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+static Expected<uint32_t> parseAddress(const std::string& address)
+{
+    in_addr addr;
+    if (inet_pton(AF_INET, address.c_str(), &addr) != 1) {
+        return unexpected("Wrong address '{}'", address);
+    }
+    return ntohl(addr.s_addr);
+}
+
+static std::string toString(uint32_t address)
+{
+    in_addr addr;
+    addr.s_addr = htonl(address);
+
+    char buff[INET_ADDRSTRLEN];
+    return inet_ntop(AF_INET, &addr, buff, sizeof(buff));
+}
+
+struct Range
+{
+    uint64_t first = 0;
+    uint64_t last  = 0;
+};
+
+static Expected<Range> parseRange(const std::string& range)
+{
+    if (auto pos = range.find('/'); pos != std::string::npos) {
+        auto addr = parseAddress(range.substr(0, pos));
+        if (!addr) {
+            return unexpected(addr.error());
+        }
+
+        std::string prefixStr = range.substr(pos + 1);
+        if (prefixStr.empty() || prefixStr.size() > 2 ||
+            prefixStr.find_first_not_of("0123456789") != std::string::npos) {
+            return unexpected("Wrong prefix length in '{}'", range);
+        }
+        uint32_t prefix = uint32_t(std::stoul(prefixStr));
+        if (prefix > 32) {
+            return unexpected("Wrong prefix length in '{}'", range);
+        }
+
+        uint32_t mask    = prefix ? ~uint32_t(0) << (32 - prefix) : 0;
+        uint64_t network = *addr & mask;
+        uint64_t last    = network | ~mask;
+        if (prefix < 31) {
+            // Skip network and broadcast addresses
+            return Range{network + 1, last - 1};
+        }
+        return Range{network, last};
+    }
+
+    if (auto pos = range.find('-'); pos != std::string::npos) {
+        auto first = parseAddress(range.substr(0, pos));
+        if (!first) {
+            return unexpected(first.error());
+        }
+
+        std::string lastStr = range.substr(pos + 1);
+        if (lastStr.find('.') == std::string::npos) {
+            // Short form: 10.0.0.1-20
+            lastStr = range.substr(0, range.rfind('.', pos) + 1) + lastStr;
+        }
+        auto last = parseAddress(lastStr);
+        if (!last) {
+            return unexpected(last.error());
+        }
+        if (*last < *first) {
+            return unexpected("Wrong range '{}'", range);
+        }
+        return Range{*first, *last};
+    }
+
+    auto addr = parseAddress(range);
+    if (!addr) {
+        return unexpected(addr.error());
+    }
+    return Range{*addr, *addr};
+}
+
+// =====================================================================================================================
+
+Expected<std::vector<std::string>> expandRanges(const std::vector<std::string>& ranges, size_t limit)
+{
+    std::set<uint32_t> addresses;
+    for (const auto& str : ranges) {
+        auto range = parseRange(str);
+        if (!range) {
+            return unexpected(range.error());
+        }
+        if (range->last - range->first + 1 > limit) {
+            return unexpected("Range '{}' is too big, maximum is {} addresses", str, limit);
+        }
+        for (uint64_t addr = range->first; addr <= range->last; ++addr) {
+            addresses.insert(uint32_t(addr));
+        }
+        if (addresses.size() > limit) {
+            return unexpected("Too many addresses to scan, maximum is {}", limit);
+        }
+    }
+
+    std::vector<std::string> out;
+    out.reserve(addresses.size());
+    for (uint32_t addr : addresses) {
+        out.push_back(toString(addr));
+    }
+    return out;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -0,0 +1,33 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <fty/expected.h>
+#include <string>
+#include <vector>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Expands list of IPv4 ranges into the list of addresses.
+/// Supported formats: single address (10.0.0.1), CIDR block (10.0.0.0/24), range (10.0.0.1-10.0.0.20 or 10.0.0.1-20).
+/// Network and broadcast addresses of CIDR blocks are skipped, duplicates are removed.
+Expected<std::vector<std::string>> expandRanges(const std::vector<std::string>& ranges, size_t limit);
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -0,0 +1,79 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Object name resolved at compile time
+struct KnownOid
+{
+    static constexpr size_t MaxLen = 16;
+
+    std::string_view name;
+    size_t           len;
+    uint32_t         oid[MaxLen];
+};
+
+// clang-format off
+/// Objects read by discovery on every device: fixed reads and probed objects of known MIBs
+inline constexpr KnownOid KnownOids[] = {
+    {"RFC1213-MIB::sysObjectID.0",              9,  {1, 3, 6, 1, 2, 1, 1, 2, 0}},
+    {"SNMPv2-MIB::sysObjectID.0",               9,  {1, 3, 6, 1, 2, 1, 1, 2, 0}},
+    {"SNMPv2-MIB::sysDescr.0",                  9,  {1, 3, 6, 1, 2, 1, 1, 1, 0}},
+    {"PowerNet-MIB::atsIdentModelNumber.0",     13, {1, 3, 6, 1, 4, 1, 318, 1, 1, 8, 1, 5, 0}},
+    {"PowerNet-MIB::upsBasicIdentModel.0",      14, {1, 3, 6, 1, 4, 1, 318, 1, 1, 1, 1, 1, 1, 0}},
+    {"PowerNet-MIB::sPDUIdentModelNumber.0",    13, {1, 3, 6, 1, 4, 1, 318, 1, 1, 4, 1, 4, 0}},
+    {"Baytech-MIB-503-1::sBTAModulesRPCType.1", 14, {1, 3, 6, 1, 4, 1, 4779, 1, 3, 5, 2, 1, 24, 1}},
+    {"BESTPOWER-MIB::upsIdentModel.0",          11, {1, 3, 6, 1, 4, 1, 2947, 1, 1, 2, 0}},
+    {"CPQPOWER-MIB::upsIdentManufacturer.0",    12, {1, 3, 6, 1, 4, 1, 232, 165, 3, 1, 1, 0}},
+    {"CPS-MIB::upsBaseIdentModel.0",            14, {1, 3, 6, 1, 4, 1, 3808, 1, 1, 1, 1, 1, 1, 0}},
+    {"DeltaUPS-MIB::upsv4",                     9,  {1, 3, 6, 1, 4, 1, 2254, 2, 4}},
+    {"EATON-OIDS::sts",                         8,  {1, 3, 6, 1, 4, 1, 534, 10}},
+    {"EATON-GENESIS-II-MIB::productTitle.0",    11, {1, 3, 6, 1, 4, 1, 17373, 3, 1, 1, 0}},
+    {"EATON-EPDU-MIB::productName.0",           15, {1, 3, 6, 1, 4, 1, 534, 6, 6, 7, 1, 2, 1, 2, 0}},
+    {"EATON-EPDU-PU-SW-MIB::pulizzi.1",         8,  {1, 3, 6, 1, 4, 1, 20677, 1}},
+    {"CPQPOWER-MIB::pdu2Model.0",               14, {1, 3, 6, 1, 4, 1, 232, 165, 7, 1, 2, 1, 3, 0}},
+    {"TRIPPUPS1-MIB::trippUPS1",                8,  {1, 3, 6, 1, 4, 1, 850, 1}},
+    {"UPS-MIB::upsIdentManufacturer.0",         11, {1, 3, 6, 1, 2, 1, 33, 1, 1, 1, 0}},
+    {"MG-SNMP-UPS-MIB::upsmgIdentFamilyName.0", 11, {1, 3, 6, 1, 4, 1, 705, 1, 1, 1, 0}},
+    {"XUPS-MIB::xupsIdentModel.0",              11, {1, 3, 6, 1, 4, 1, 534, 1, 1, 2, 0}},
+    {"EATON-OIDS::eatonPowerChainDevice",       9,  {1, 3, 6, 1, 4, 1, 534, 2, 12}},
+    {"XPPC-MIB::ppc",                           7,  {1, 3, 6, 1, 4, 1, 935}},
+};
+// clang-format on
+
+/// Returns compile time resolved object or nullptr
+constexpr const KnownOid* findKnownOid(std::string_view name)
+{
+    for (const auto& known : KnownOids) {
+        if (known.name == name) {
+            return &known;
+        }
+    }
+    return nullptr;
+}
+
+static_assert(findKnownOid("RFC1213-MIB::sysObjectID.0")->len == 9);
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -0,0 +1,341 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "mib-snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+// File layout: header, records sorted by oid, record indexes sorted by name, pool of oid components, pool of names
+static constexpr char Magic[8] = {'F', 'T', 'Y', 'M', 'I', 'B', '0', '1'};
+
+struct MibSnapshot::Header
+{
+    char     magic[8];
+    uint32_t count;
+    uint32_t oidsCount;
+    uint32_t namesSize;
+    uint32_t reserved;
+};
+
+struct MibSnapshot::Record
+{
+    uint32_t oid;
+    uint32_t oidLen;
+    uint32_t name;
+    uint32_t nameLen;
+};
+
+// =====================================================================================================================
+
+/// Appends dot separated numbers (.1.3.6 or 1.3.6) to oid
+static bool appendNumbers(const std::string& str, MibSnapshot::Oid& oid)
+{
+    size_t pos = !str.empty() && str[0] == '.' ? 1 : 0;
+    if (pos >= str.size()) {
+        return str.empty();
+    }
+
+    while (true) {
+        size_t      next = str.find('.', pos);
+        std::string part = str.substr(pos, next == std::string::npos ? std::string::npos : next - pos);
+        if (part.empty() || part.size() > 10 || !std::all_of(part.begin(), part.end(), ::isdigit)) {
+            return false;
+        }
+        auto val = std::stoull(part);
+        if (val > std::numeric_limits<uint32_t>::max()) {
+            return false;
+        }
+        oid.push_back(uint32_t(val));
+        if (next == std::string::npos) {
+            return true;
+        }
+        pos = next + 1;
+    }
+}
+
+MibSnapshot::~MibSnapshot()
+{
+    if (m_data) {
+        munmap(m_data, m_size);
+    }
+}
+
+Expected<void> MibSnapshot::write(const std::string& path, std::vector<Entry> entries)
+{
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& l, const Entry& r) {
+        return l.oid < r.oid;
+    });
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                      [](const Entry& l, const Entry& r) {
+                          return l.oid == r.oid && l.name == r.name;
+                      }),
+        entries.end());
+
+    std::vector<Record>   records;
+    std::vector<uint32_t> oids;
+    std::string           names;
+    for (const auto& entry : entries) {
+        records.push_back({uint32_t(oids.size()), uint32_t(entry.oid.size()), uint32_t(names.size()),
+            uint32_t(entry.name.size())});
+        oids.insert(oids.end(), entry.oid.begin(), entry.oid.end());
+        names += entry.name;
+    }
+
+    std::vector<uint32_t> byName(records.size());
+    for (uint32_t i = 0; i < byName.size(); ++i) {
+        byName[i] = i;
+    }
+    std::sort(byName.begin(), byName.end(), [&](uint32_t l, uint32_t r) {
+        return entries[l].name < entries[r].name;
+    });
+
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.count     = uint32_t(records.size());
+    header.oidsCount = uint32_t(oids.size());
+    header.namesSize = uint32_t(names.size());
+    header.reserved  = 0;
+
+    std::ofstream st(path, std::ios::binary | std::ios::trunc);
+    if (!st) {
+        return unexpected("Cannot write '{}'", path);
+    }
+    st.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    st.write(reinterpret_cast<const char*>(records.data()), std::streamsize(records.size() * sizeof(Record)));
+    st.write(reinterpret_cast<const char*>(byName.data()), std::streamsize(byName.size() * sizeof(uint32_t)));
+    st.write(reinterpret_cast<const char*>(oids.data()), std::streamsize(oids.size() * sizeof(uint32_t)));
+    st.write(names.data(), std::streamsize(names.size()));
+    if (!st) {
+        return unexpected("Cannot write '{}'", path);
+    }
+    return {};
+}
+
+Expected<std::unique_ptr<MibSnapshot>> MibSnapshot::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return unexpected("Cannot open '{}': {}", path, strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return unexpected("Wrong snapshot '{}'", path);
+    }
+
+    std::unique_ptr<MibSnapshot> snap(new MibSnapshot);
+
+    snap->m_size = size_t(st.st_size);
+    snap->m_data = mmap(nullptr, snap->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (snap->m_data == MAP_FAILED) {
+        snap->m_data = nullptr;
+        return unexpected("Cannot map '{}': {}", path, strerror(errno));
+    }
+
+    auto begin     = static_cast<const char*>(snap->m_data);
+    snap->m_header = reinterpret_cast<const Header*>(begin);
+
+    const Header& hdr = *snap->m_header;
+    if (memcmp(hdr.magic, Magic, sizeof(Magic)) != 0) {
+        return unexpected("Wrong snapshot '{}'", path);
+    }
+
+    size_t expected = sizeof(Header) + hdr.count * (sizeof(Record) + sizeof(uint32_t)) +
+                      hdr.oidsCount * sizeof(uint32_t) + hdr.namesSize;
+    if (expected != snap->m_size) {
+        return unexpected("Wrong snapshot '{}'", path);
+    }
+
+    snap->m_records = reinterpret_cast<const Record*>(begin + sizeof(Header));
+    snap->m_byName  = reinterpret_cast<const uint32_t*>(snap->m_records + hdr.count);
+    snap->m_oids    = snap->m_byName + hdr.count;
+    snap->m_names   = reinterpret_cast<const char*>(snap->m_oids + hdr.oidsCount);
+
+    std::map<std::string_view, uint32_t> moduleIds;
+    for (uint32_t i = 0; i < hdr.count; ++i) {
+        const Record& rec = snap->m_records[i];
+        if (size_t(rec.oid) + rec.oidLen > hdr.oidsCount || size_t(rec.name) + rec.nameLen > hdr.namesSize ||
+            snap->m_byName[i] >= hdr.count) {
+            return unexpected("Wrong snapshot '{}'", path);
+        }
+
+        // Several names of the same object, first one wins as in print
+        if (i > 0 && snap->compare(snap->m_records[i - 1], snap->m_oids + rec.oid, rec.oidLen) == 0) {
+            continue;
+        }
+        std::string_view name(snap->m_names + rec.name, rec.nameLen);
+        std::string_view module = name.substr(0, name.find("::"));
+
+        auto it = moduleIds.find(module);
+        if (it == moduleIds.end()) {
+            it = moduleIds.emplace(module, uint32_t(snap->m_moduleNames.size())).first;
+            snap->m_moduleNames.push_back(module);
+        }
+        snap->m_modules.insert(snap->m_oids + rec.oid, rec.oidLen, it->second);
+    }
+
+    return std::move(snap);
+}
+
+size_t MibSnapshot::size() const
+{
+    return m_header->count;
+}
+
+Expected<MibSnapshot::Oid> MibSnapshot::parse(const std::string& name) const
+{
+    Oid         ret;
+    std::string suffix;
+
+    if (!name.empty() && (name[0] == '.' || isdigit(name[0]))) {
+        suffix = name;
+    } else {
+        size_t      dot   = name.find('.', name.find("::") == std::string::npos ? 0 : name.find("::") + 2);
+        std::string label = name.substr(0, dot);
+        if (dot != std::string::npos) {
+            suffix = name.substr(dot);
+        }
+
+        const Record* rec = find(label);
+        if (!rec) {
+            return unexpected("Unknown object '{}'", label);
+        }
+        ret = oid(*rec);
+    }
+
+    if (!appendNumbers(suffix, ret) || ret.empty()) {
+        return unexpected("Cannot parse OID '{}'", name);
+    }
+    return std::move(ret);
+}
+
+std::string MibSnapshot::print(const Oid& value) const
+{
+    for (size_t len = value.size(); len > 0; --len) {
+        if (auto rec = find(value.data(), len)) {
+            std::string ret = name(*rec);
+            for (size_t i = len; i < value.size(); ++i) {
+                ret += "." + std::to_string(value[i]);
+            }
+            return ret;
+        }
+    }
+
+    std::string ret;
+    for (auto part : value) {
+        ret += "." + std::to_string(part);
+    }
+    return ret;
+}
+
+std::string_view MibSnapshot::module(const uint32_t* oid, size_t len) const
+{
+    auto id = moduleId(oid, len);
+    return id != NoModule ? m_moduleNames[id] : std::string_view();
+}
+
+uint32_t MibSnapshot::moduleId(const uint32_t* oid, size_t len) const
+{
+    auto found = m_modules.find(oid, len);
+    return found ? *found : NoModule;
+}
+
+std::string_view MibSnapshot::moduleName(uint32_t id) const
+{
+    return m_moduleNames.at(id);
+}
+
+size_t MibSnapshot::modulesCount() const
+{
+    return m_moduleNames.size();
+}
+
+MibSnapshot::Oid MibSnapshot::oid(const Record& rec) const
+{
+    return Oid(m_oids + rec.oid, m_oids + rec.oid + rec.oidLen);
+}
+
+std::string MibSnapshot::name(const Record& rec) const
+{
+    return std::string(m_names + rec.name, rec.nameLen);
+}
+
+int MibSnapshot::compare(const Record& rec, const uint32_t* value, size_t len) const
+{
+    const uint32_t* recOid = m_oids + rec.oid;
+    for (size_t i = 0; i < rec.oidLen && i < len; ++i) {
+        if (recOid[i] != value[i]) {
+            return recOid[i] < value[i] ? -1 : 1;
+        }
+    }
+    if (rec.oidLen == len) {
+        return 0;
+    }
+    return rec.oidLen < len ? -1 : 1;
+}
+
+const MibSnapshot::Record* MibSnapshot::find(const uint32_t* value, size_t len) const
+{
+    const Record* end = m_records + m_header->count;
+    const Record* it  = std::lower_bound(m_records, end, 0, [&](const Record& rec, int) {
+        return compare(rec, value, len) < 0;
+    });
+    return it != end && compare(*it, value, len) == 0 ? it : nullptr;
+}
+
+const MibSnapshot::Record* MibSnapshot::find(const std::string& label) const
+{
+    if (label.find("::") == std::string::npos) {
+        // Name without module, take any module defining it
+        std::string suffix = "::" + label;
+        for (uint32_t i = 0; i < m_header->count; ++i) {
+            const Record& rec = m_records[i];
+            if (rec.nameLen > suffix.size() &&
+                memcmp(m_names + rec.name + rec.nameLen - suffix.size(), suffix.data(), suffix.size()) == 0) {
+                return &rec;
+            }
+        }
+        return nullptr;
+    }
+
+    const uint32_t* end = m_byName + m_header->count;
+    const uint32_t* it  = std::lower_bound(m_byName, end, label, [&](uint32_t idx, const std::string& val) {
+        const Record& rec = m_records[idx];
+        return std::string_view(m_names + rec.name, rec.nameLen) < val;
+    });
+    if (it != end && std::string_view(m_names + m_records[*it].name, m_records[*it].nameLen) == label) {
+        return &m_records[*it];
+    }
+    return nullptr;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl
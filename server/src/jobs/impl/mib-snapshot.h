@@ -0,0 +1,108 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "oid-trie.h"
+#include <cstdint>
+#include <fty/expected.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Compiled table of MIB symbols.
+/// Holds only symbols used by discovery (probed objects, known sysObjectID values) and the roots of every MIB module,
+/// so names can be resolved and printed without loading MIB files. Snapshot is generated at build time by
+/// fty-mib-snapshot and is memory mapped at runtime.
+class MibSnapshot
+{
+public:
+    using Oid = std::vector<uint32_t>;
+
+    /// Snapshot file name in MIB database directory
+    static constexpr const char* FileName = "mibs.snapshot";
+
+    struct Entry
+    {
+        Oid         oid;
+        std::string name; // MODULE::label
+    };
+
+    ~MibSnapshot();
+
+    /// Writes snapshot file from list of symbols, first name of the same oid is the one printed
+    static Expected<void> write(const std::string& path, std::vector<Entry> entries);
+
+    /// Maps snapshot file into memory
+    static Expected<std::unique_ptr<MibSnapshot>> open(const std::string& path);
+
+    /// Resolves numeric (.1.3.6.1.2.1.1.2.0) or symbolic (SNMPv2-MIB::sysObjectID.0, sysObjectID.0) object name
+    Expected<Oid> parse(const std::string& name) const;
+
+    /// Prints object name as MODULE::label.suffix using the longest known prefix, or numeric if nothing is known
+    std::string print(const Oid& oid) const;
+
+    /// Module id returned when no prefix of object id is known
+    static constexpr uint32_t NoModule = UINT32_MAX;
+
+    /// Returns MIB module of the longest known prefix of object id, empty if nothing is known
+    std::string_view module(const uint32_t* oid, size_t len) const;
+
+    /// Returns index of MIB module of the longest known prefix of object id, or NoModule
+    uint32_t moduleId(const uint32_t* oid, size_t len) const;
+
+    /// Returns name of MIB module by its index
+    std::string_view moduleName(uint32_t id) const;
+
+    /// Number of MIB modules in the snapshot, module indexes are below it
+    size_t modulesCount() const;
+
+    /// Number of symbols in the snapshot
+    size_t size() const;
+
+private:
+    struct Header;
+    struct Record;
+
+    MibSnapshot() = default;
+
+    Oid         oid(const Record& rec) const;
+    std::string name(const Record& rec) const;
+    int         compare(const Record& rec, const uint32_t* oid, size_t len) const;
+
+    const Record* find(const uint32_t* oid, size_t len) const;
+    const Record* find(const std::string& name) const;
+
+private:
+    void*           m_data    = nullptr;
+    size_t          m_size    = 0;
+    const Header*   m_header  = nullptr;
+    const Record*   m_records = nullptr;
+    const uint32_t* m_byName  = nullptr;
+    const uint32_t* m_oids    = nullptr;
+    const char*     m_names   = nullptr;
+
+    OidTrie<uint32_t>             m_modules;     // subtree -> module index
+    std::vector<std::string_view> m_moduleNames; // views to mapped names
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl
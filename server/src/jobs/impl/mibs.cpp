@@ -15,11 +15,14 @@
 */
 
 #include "mibs.h"
+#include "mib-snapshot.h"
 #include "snmp.h"
 #include "src/config.h"
-#include <regex>
 #include <fty_log.h>
 #include <iostream>
+#include <future>
+#include <map>
+#include <string_view>
 
 
 namespace fty::impl {
@@ -28,8 +31,29 @@ namespace fty::impl {
 
 bool filterMib(const std::string& mib)
 {
-    static std::regex rex("^(IP-MIB|DISMAN-EVENT-MIB|RFC1213-MIB|SNMP-|TCP-MIB|UDP-MIB).*");
-    return !std::regex_match(mib, rex);
+    // Generic modules which every agent implements, they say nothing about device
+    static constexpr std::string_view skipped[] = {
+        "IP-MIB", "DISMAN-EVENT-MIB", "RFC1213-MIB", "SNMP-", "TCP-MIB", "UDP-MIB"};
+
+    for (const auto& prefix : skipped) {
+        if (mib.compare(0, prefix.size(), prefix) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Modules of MIB snapshot which pass filterMib, indexed by module id, computed once
+static const std::vector<bool>& allowedModules(const MibSnapshot& snap)
+{
+    static std::vector<bool> allowed = [&]() {
+        std::vector<bool> ret(snap.modulesCount());
+        for (uint32_t id = 0; id < ret.size(); ++id) {
+            ret[id] = filterMib(std::string(snap.moduleName(id)));
+        }
+        return ret;
+    }();
+    return allowed;
 }
 
 static const std::vector<std::string>& knownMibs()
@@ -63,7 +87,7 @@ bool isSnmpSupported(const std::string& mib)
     return !mapMibToLegacy(mib).empty();
 }
 
-std::string mapMibToLegacy(const std::string& mib)
+static const std::map<std::string, std::string>& legacyMibs()
 {
     // clang-format off
     static std::map<std::string, std::string> mibs = {
@@ -102,8 +126,25 @@ std::string mapMibToLegacy(const std::string& mib)
         {"UPS-MIB::upsMIB",                     "ietf"},                // ietf
     };
     // clang-format on
-    auto it = mibs.find(mib);
-    return it != mibs.end() ? it->second : "";
+    return mibs;
+}
+
+std::string mapMibToLegacy(const std::string& mib)
+{
+    auto it = legacyMibs().find(mib);
+    return it != legacyMibs().end() ? it->second : "";
+}
+
+std::vector<std::string> usedSymbols()
+{
+    std::vector<std::string> symbols = {"RFC1213-MIB::sysObjectID", "SNMPv2-MIB::sysDescr"};
+    for (const auto& mib : knownMibs()) {
+        symbols.push_back(mib.substr(0, mib.find('.')));
+    }
+    for (const auto& it : legacyMibs()) {
+        symbols.push_back(it.first.substr(0, it.first.find('.')));
+    }
+    return symbols;
 }
 
 // =====================================================================================================================
@@ -128,7 +169,7 @@ Expected<void> MibsReader::setTimeout(uint miliseconds)
     return m_session->setTimeout(miliseconds);
 }
 
-Expected<MibsReader::MibList> MibsReader::read() const
+Expected<void> MibsReader::open() const
 {
     if (!m_isOpen) {
         if (auto res = m_session->open(); !res) {
@@ -136,63 +177,139 @@ Expected<MibsReader::MibList> MibsReader::read() const
         }
         m_isOpen = true;
     }
+    return {};
+}
 
-    MibList mibs;
+const snmp::SessionPtr& MibsReader::session() const
+{
+    return m_session;
+}
 
-    auto oid = m_session->read("RFC1213-MIB::sysObjectID.0");
-    if (oid) {
-        size_t pos;
-        if (pos = oid->find("."); pos != std::string::npos) {
-            mibs.insert(oid->substr(0, pos));
-        } else {
-            mibs.insert(*oid);
-        }
+Expected<MibsReader::MibList> MibsReader::read() const
+{
+    std::promise<Expected<MibList>> promise;
+    read([&](Expected<MibList>&& mibs) {
+        promise.set_value(std::move(mibs));
+    });
+    return promise.get_future().get();
+}
+
+static Expected<MibsReader::MibList> found(MibsReader::MibList&& mibs)
+{
+    if (mibs.empty()) {
+        return unexpected("Cannot fetch mibs from endpoint. Host is not available or SNMP is not supported.");
+    }
+    return std::move(mibs);
+}
+
+static void walkMibs(const snmp::SessionPtr& session, MibsReader::MibsFunc&& then)
+{
+    // Classification state lives as long as the walk
+    struct State
+    {
+        MibsReader::MibList        mibs;
+        std::vector<bool>          seen;
+        std::set<std::string_view> checked;
+    };
+    auto state = std::make_shared<State>();
+
+    // Walk yields tens of thousands of objects, every one is classified by integer lookups only
+    snmp::WalkFunc classify;
+    if (auto snap = Snmp::instance().snapshot()) {
+        const auto& allowed = allowedModules(*snap);
+        state->seen.resize(allowed.size());
+        classify = [state, snap, &allowed](const snmp::OidView& oid, const snmp::Value&) {
+            auto id = snap->moduleId(oid.data, oid.size);
+            if (id != MibSnapshot::NoModule && allowed[id] && !state->seen[id]) {
+                state->seen[id] = true;
+                state->mibs.emplace(snap->moduleName(id));
+            }
+        };
     } else {
-        if (fty::Config::instance().tryAll) {
-            auto res = m_session->walk([&](const std::string& mib) {
-                if (filterMib(mib)) {
-                    size_t pos;
-                    if (pos = mib.find("::"); pos != std::string::npos) {
-                        mibs.insert(mib.substr(0, pos));
-                    }
-                }
-            });
-            if (!res) {
-                return unexpected(res.error());
+        classify = [state](const snmp::OidView& oid, const snmp::Value&) {
+            auto module = Snmp::instance().module(oid);
+            if (!module.empty() && state->checked.insert(module).second && filterMib(std::string(module))) {
+                state->mibs.emplace(module);
             }
+        };
+    }
+
+    session->walk(std::move(classify), [session, state, then = std::move(then)](const Expected<void>& res) {
+        if (!res) {
+            then(unexpected(res.error()));
         } else {
-            for (const std::string& mib : knownMibs()) {
-                if (auto val = m_session->read(mib); !val) {
-                    continue;
-                }
-
-                size_t pos;
-                if (pos = mib.find("::"); pos != std::string::npos) {
-                    mibs.insert(mib.substr(0, pos));
-                }
-            }
+            then(found(std::move(state->mibs)));
         }
-        if (mibs.empty()) {
-            return unexpected("Cannot fetch mibs from endpoint. Host is not available or SNMP is not supported.");
+    });
+}
+
+static void readKnownMibs(const snmp::SessionPtr& session, MibsReader::MibsFunc&& then)
+{
+    // All candidates are packed in one request, so detection costs one or two round trips
+    session->read(knownMibs(), [session, then = std::move(then)](std::vector<Expected<std::string>>&& values) {
+        MibsReader::MibList mibs;
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (!values[i]) {
+                continue;
+            }
+
+            const std::string& mib = knownMibs()[i];
+            size_t             pos;
+            if (pos = mib.find("::"); pos != std::string::npos) {
+                mibs.insert(mib.substr(0, pos));
+            }
         }
+        then(found(std::move(mibs)));
+    });
+}
+
+void MibsReader::read(MibsFunc&& then) const
+{
+    if (auto res = open(); !res) {
+        then(unexpected(res.error()));
+        return;
     }
 
-    return std::move(mibs);
+    // Every step is sent by the answer of the previous one, callbacks keep the session alive
+    auto session = m_session;
+    session->read("RFC1213-MIB::sysObjectID.0", [session, then = std::move(then)](const Expected<std::string>& oid) {
+        if (oid) {
+            MibList mibs;
+            size_t  pos;
+            if (pos = oid->find("."); pos != std::string::npos) {
+                mibs.insert(oid->substr(0, pos));
+            } else {
+                mibs.insert(*oid);
+            }
+            then(std::move(mibs));
+        } else if (fty::Config::instance().tryAll) {
+            walkMibs(session, MibsFunc(then));
+        } else {
+            readKnownMibs(session, MibsFunc(then));
+        }
+    });
 }
 
 Expected<std::string> MibsReader::readName() const
 {
-    if (!m_isOpen) {
-        if (auto res = m_session->open(); !res) {
-            return unexpected(res.error());
-        }
-        m_isOpen = true;
-    }
-    auto name = m_session->read("SNMPv2-MIB::sysDescr.0");
-    if (!name) {
-        return unexpected(name.error());
+    std::promise<Expected<std::string>> promise;
+    readName([&](const Expected<std::string>& name) {
+        promise.set_value(name);
+    });
+    return promise.get_future().get();
+}
+
+void MibsReader::readName(NameFunc&& then) const
+{
+    if (auto res = open(); !res) {
+        then(unexpected(res.error()));
+        return;
     }
-    return *name;
+
+    auto session = m_session;
+    session->read("SNMPv2-MIB::sysDescr.0", [session, then = std::move(then)](const Expected<std::string>& name) {
+        then(name);
+    });
 }
 
 // =====================================================================================================================
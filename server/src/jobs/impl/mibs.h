@@ -16,9 +16,11 @@
 
 #pragma once
 #include <fty/expected.h>
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace fty::impl {
 
@@ -28,6 +30,9 @@ bool        isSnmpSupported(const std::string& mib);
 std::string mapMibToLegacy(const std::string& mib);
 bool        filterMib(const std::string& mib);
 
+/// Symbols read or matched by discovery, they are compiled into MIB snapshot
+std::vector<std::string> usedSymbols();
+
 // =====================================================================================================================
 
 namespace snmp {
@@ -39,7 +44,9 @@ namespace snmp {
 class MibsReader
 {
 public:
-    using MibList = std::set<std::string>;
+    using MibList  = std::set<std::string>;
+    using MibsFunc = std::function<void(Expected<MibList>&& mibs)>;
+    using NameFunc = std::function<void(const Expected<std::string>& name)>;
 
     MibsReader(const std::string& address, uint16_t port);
     Expected<void> setCredentialId(const std::string& credentialId);
@@ -49,6 +56,16 @@ public:
     Expected<MibList>     read() const;
     Expected<std::string> readName() const;
 
+    /// Asynchronous variants, result is delivered to callback by SNMP engine thread, callback must not block
+    void read(MibsFunc&& then) const;
+    void readName(NameFunc&& then) const;
+
+    /// Session opened by the reader, further reads of the same device reuse it
+    const snmp::SessionPtr& session() const;
+
+private:
+    Expected<void> open() const;
+
 private:
     snmp::SessionPtr m_session;
     mutable bool     m_isOpen = false;
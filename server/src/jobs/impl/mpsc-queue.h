@@ -0,0 +1,91 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <atomic>
+#include <optional>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Unbounded lock-free queue with many producers and a single consumer (intrusive list of D. Vyukov).
+/// Push is wait-free, pop must be called from one thread only. A value pushed while pop runs can be missed by that
+/// pop, so producers have to wake the consumer after pushing.
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+        : m_head(new Node)
+        , m_tail(m_head.load(std::memory_order_relaxed))
+    {
+    }
+
+    ~MpscQueue()
+    {
+        while (pop()) {
+        }
+        delete m_tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /// Adds value to the queue, can be called from any thread
+    void push(T&& value)
+    {
+        Node* node = new Node(std::move(value));
+        Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /// Takes the oldest value, must be called from consumer thread only
+    std::optional<T> pop()
+    {
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return std::nullopt;
+        }
+
+        std::optional<T> value = std::move(next->value);
+        next->value.reset();
+        m_tail = next;
+        delete tail;
+        return value;
+    }
+
+private:
+    struct Node
+    {
+        Node() = default;
+        explicit Node(T&& val)
+            : value(std::move(val))
+        {
+        }
+
+        std::atomic<Node*> next = nullptr;
+        std::optional<T>   value;
+    };
+
+    std::atomic<Node*> m_head;
+    Node*              m_tail;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -0,0 +1,334 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "child-process.h"
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <fty_log.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace fty::impl::nut {
+
+// =====================================================================================================================
+
+/// Standard error is only shown in error messages, the rest of it is dropped
+static constexpr size_t MaxErrors = 64 * 1024;
+
+/// Time given to the process to stop by SIGTERM before it is killed
+static constexpr auto TermGrace = std::chrono::milliseconds(500);
+
+/// Limit lowered to the current hard one, which cannot be raised without privileges
+static rlimit limit(int resource, rlim_t soft, rlim_t hard)
+{
+    rlimit current = {RLIM_INFINITY, RLIM_INFINITY};
+    getrlimit(resource, &current);
+    return {std::min(soft, current.rlim_max), std::min(hard, current.rlim_max)};
+}
+
+static void closeFd(int& fd)
+{
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+// =====================================================================================================================
+
+ChildProcess::ChildProcess(const std::string& path, const std::vector<std::string>& args)
+    : m_path(path)
+    , m_args(args)
+{
+}
+
+ChildProcess::~ChildProcess()
+{
+    kill();
+}
+
+void ChildProcess::addArgument(const std::string& arg)
+{
+    m_args.push_back(arg);
+}
+
+void ChildProcess::setEnvVar(const std::string& name, const std::string& value)
+{
+    m_env[name] = value;
+}
+
+void ChildProcess::setLimits(uint32_t cpuSeconds, uint64_t memoryBytes)
+{
+    m_cpuSeconds  = cpuSeconds;
+    m_memoryBytes = memoryBytes;
+}
+
+Expected<void> ChildProcess::start()
+{
+    int out[2];
+    int err[2];
+    int status[2];
+    if (pipe2(out, O_CLOEXEC) != 0) {
+        return unexpected("Cannot create pipe: {}", strerror(errno));
+    }
+    if (pipe2(err, O_CLOEXEC) != 0) {
+        close(out[0]);
+        close(out[1]);
+        return unexpected("Cannot create pipe: {}", strerror(errno));
+    }
+    if (pipe2(status, O_CLOEXEC) != 0) {
+        for (int fd : {out[0], out[1], err[0], err[1]}) {
+            close(fd);
+        }
+        return unexpected("Cannot create pipe: {}", strerror(errno));
+    }
+
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(m_path.c_str()));
+    for (auto& arg : m_args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    std::map<std::string, std::string> vars;
+    for (char** var = environ; var && *var; ++var) {
+        std::string_view str(*var);
+        auto             pos = str.find('=');
+        if (pos != std::string_view::npos) {
+            vars.emplace(str.substr(0, pos), str.substr(pos + 1));
+        }
+    }
+    for (const auto& [name, value] : m_env) {
+        vars[name] = value;
+    }
+    std::vector<std::string> envStrings;
+    for (const auto& [name, value] : vars) {
+        envStrings.push_back(name + "=" + value);
+    }
+    std::vector<char*> envp;
+    for (auto& var : envStrings) {
+        envp.push_back(const_cast<char*>(var.c_str()));
+    }
+    envp.push_back(nullptr);
+
+    // SIGXCPU is sent at soft cpu limit, SIGKILL at hard one
+    rlimit cpu = limit(RLIMIT_CPU, m_cpuSeconds, m_cpuSeconds + 1);
+    rlimit mem = limit(RLIMIT_AS, m_memoryBytes, m_memoryBytes);
+
+    // posix_spawn cannot set limits of the child, so it is forked and limits are set before exec: driver never runs
+    // without them. Everything is prepared above, only async signal safe calls are made in the child.
+    m_pid         = fork();
+    int forkError = errno;
+    if (m_pid == 0) {
+        // Child gets write ends as stdout and stderr, all other descriptors are closed on exec
+        sigset_t none;
+        sigemptyset(&none);
+        if (dup2(out[1], STDOUT_FILENO) >= 0 && dup2(err[1], STDERR_FILENO) >= 0 &&
+            sigprocmask(SIG_SETMASK, &none, nullptr) == 0 && (!m_cpuSeconds || setrlimit(RLIMIT_CPU, &cpu) == 0) &&
+            (!m_memoryBytes || setrlimit(RLIMIT_AS, &mem) == 0)) {
+            execve(m_path.c_str(), argv.data(), envp.data());
+        }
+        int                   error   = errno;
+        [[maybe_unused]] auto written = write(status[1], &error, sizeof(error));
+        _exit(127);
+    }
+
+    close(out[1]);
+    close(err[1]);
+    close(status[1]);
+
+    if (m_pid < 0) {
+        for (int fd : {out[0], err[0], status[0]}) {
+            close(fd);
+        }
+        return unexpected("Cannot run {}: {}", m_path, strerror(forkError));
+    }
+
+    // Status pipe is closed by successful exec, child which failed writes errno to it
+    int     error = 0;
+    ssize_t len   = 0;
+    while ((len = ::read(status[0], &error, sizeof(error))) < 0 && errno == EINTR) {
+    }
+    close(status[0]);
+
+    if (len > 0) {
+        while (waitpid(m_pid, nullptr, 0) < 0 && errno == EINTR) {
+        }
+        close(out[0]);
+        close(err[0]);
+        m_pid = -1;
+        return unexpected("Cannot run {}: {}", m_path, strerror(error));
+    }
+
+    m_out = out[0];
+    m_err = err[0];
+    fcntl(m_out, F_SETFL, fcntl(m_out, F_GETFL) | O_NONBLOCK);
+    fcntl(m_err, F_SETFL, fcntl(m_err, F_GETFL) | O_NONBLOCK);
+    return {};
+}
+
+Expected<int> ChildProcess::read(LineFunc&& func, int milliseconds)
+{
+    using Clock = std::chrono::steady_clock;
+
+    if (m_pid < 0) {
+        return unexpected("Process is not running");
+    }
+
+    auto deadline = Clock::now() + std::chrono::milliseconds(milliseconds);
+
+    std::string line;
+    char        buff[4096];
+    bool        stopped = false;
+
+    while (!stopped && (m_out >= 0 || m_err >= 0)) {
+        int timeout = -1;
+        if (milliseconds >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left <= 0) {
+                kill();
+                return unexpected("Request timed out");
+            }
+            timeout = int(left);
+        }
+
+        pollfd fds[2] = {{m_out, POLLIN, 0}, {m_err, POLLIN, 0}};
+        if (int ret = poll(fds, 2, timeout); ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            kill();
+            return unexpected("Cannot read output: {}", strerror(errno));
+        } else if (ret == 0) {
+            continue;
+        }
+
+        if (fds[1].revents) {
+            ssize_t len = ::read(m_err, buff, sizeof(buff));
+            if (len > 0) {
+                m_errors.append(buff, std::min(size_t(len), MaxErrors - std::min(MaxErrors, m_errors.size())));
+            } else if (len == 0 || errno != EAGAIN) {
+                closeFd(m_err);
+            }
+        }
+
+        if (fds[0].revents) {
+            ssize_t len = ::read(m_out, buff, sizeof(buff));
+            if (len > 0) {
+                // Only an unfinished line is kept between reads
+                std::string_view chunk(buff, size_t(len));
+                for (auto pos = chunk.find('\n'); pos != std::string_view::npos && !stopped; pos = chunk.find('\n')) {
+                    line.append(chunk.substr(0, pos));
+                    stopped = !func(line);
+                    line.clear();
+                    chunk.remove_prefix(pos + 1);
+                }
+                line.append(chunk);
+            } else if (len == 0 || errno != EAGAIN) {
+                closeFd(m_out);
+            }
+        }
+    }
+
+    if (stopped) {
+        log_debug("%s: rest of output is not needed, stopping it", m_path.c_str());
+        kill();
+        return 0;
+    }
+
+    if (!line.empty()) {
+        func(line);
+    }
+
+    // Process which closed its output can still run, it is waited for till the same deadline
+    int  status = 0;
+    auto pause  = std::chrono::milliseconds(1);
+    while (true) {
+        pid_t ret = waitpid(m_pid, &status, milliseconds < 0 ? 0 : WNOHANG);
+        if (ret == m_pid) {
+            break;
+        }
+        if (ret < 0 && errno != EINTR) {
+            m_pid = -1;
+            return unexpected("Cannot wait for {}: {}", m_path, strerror(errno));
+        }
+        if (ret == 0) {
+            if (Clock::now() >= deadline) {
+                kill();
+                return unexpected("Request timed out");
+            }
+            std::this_thread::sleep_for(pause);
+            pause = std::min(pause * 2, std::chrono::milliseconds(20));
+        }
+    }
+    m_pid = -1;
+
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    return unexpected("{} was killed by signal {}", m_path, WTERMSIG(status));
+}
+
+const std::string& ChildProcess::errors() const
+{
+    return m_errors;
+}
+
+void ChildProcess::kill()
+{
+    using Clock = std::chrono::steady_clock;
+
+    closeFd(m_out);
+    closeFd(m_err);
+    if (m_pid <= 0) {
+        return;
+    }
+
+    // Driver is let to clean up its state on SIGTERM, one which does not react is killed
+    ::kill(m_pid, SIGTERM);
+    auto deadline = Clock::now() + TermGrace;
+    auto pause    = std::chrono::milliseconds(1);
+    while (true) {
+        pid_t ret = waitpid(m_pid, nullptr, WNOHANG);
+        if (ret == m_pid || (ret < 0 && errno != EINTR)) {
+            m_pid = -1;
+            return;
+        }
+        if (Clock::now() >= deadline) {
+            break;
+        }
+        std::this_thread::sleep_for(pause);
+        pause = std::min(pause * 2, std::chrono::milliseconds(20));
+    }
+
+    log_warning("%s is not stopped by SIGTERM, killing it", m_path.c_str());
+    ::kill(m_pid, SIGKILL);
+    while (waitpid(m_pid, nullptr, 0) < 0 && errno == EINTR) {
+    }
+    m_pid = -1;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl::nut
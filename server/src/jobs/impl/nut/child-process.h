@@ -0,0 +1,78 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <fty/expected.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+namespace fty::impl::nut {
+
+// =====================================================================================================================
+
+/// Driver process with standard output and error piped back.
+/// Output is handed over line by line while the driver runs, so it is never kept whole and the driver can be stopped
+/// as soon as the rest of it is not needed.
+class ChildProcess
+{
+public:
+    /// Called for every line of standard output, returns false if the rest of output is not needed
+    using LineFunc = std::function<bool(std::string_view line)>;
+
+    ChildProcess(const std::string& path, const std::vector<std::string>& args);
+    ~ChildProcess();
+
+    ChildProcess(const ChildProcess&) = delete;
+    ChildProcess& operator=(const ChildProcess&) = delete;
+
+    void addArgument(const std::string& arg);
+    void setEnvVar(const std::string& name, const std::string& value);
+
+    /// Resource limits set in the child before exec, 0 is unlimited
+    void setLimits(uint32_t cpuSeconds, uint64_t memoryBytes);
+
+    /// Spawns the process
+    Expected<void> start();
+
+    /// Reads output until the process exits, callback stops it or timeout (-1 is infinite) passes.
+    /// Returns exit status, process stopped by callback is reported as succeeded.
+    Expected<int> read(LineFunc&& func, int milliseconds = -1);
+
+    /// Standard error collected by @ref read
+    const std::string& errors() const;
+
+    /// Asks the process to terminate, kills it if it is still running after a grace period and waits for it
+    void kill();
+
+private:
+    std::string                        m_path;
+    std::vector<std::string>           m_args;
+    std::map<std::string, std::string> m_env;
+    std::string                        m_errors;
+    uint32_t                           m_cpuSeconds  = 0;
+    uint64_t                           m_memoryBytes = 0;
+    pid_t                              m_pid = -1;
+    int                                m_out = -1;
+    int                                m_err = -1;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl::nut
@@ -0,0 +1,188 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "drivers.h"
+#include "src/config.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fty_log.h>
+#include <unistd.h>
+
+namespace fty::impl::nut {
+
+// =====================================================================================================================
+
+static const std::vector<std::filesystem::path> Paths = {
+    "/usr/lib/nut", "/lib/nut", "/home/jes/workspace/fty/build/Debug/deps-runtime/bin"};
+static const std::vector<std::string>           Known = {"snmp-ups", "netxml-ups", "etn-nut-powerconnect"};
+
+// =====================================================================================================================
+
+Drivers::Slot::Slot(const std::string& driver, const std::string& stateDir)
+    : m_driver(driver)
+    , m_stateDir(stateDir)
+{
+}
+
+Drivers::Slot::Slot(Slot&& other)
+    : m_driver(std::move(other.m_driver))
+    , m_stateDir(std::move(other.m_stateDir))
+{
+    other.m_driver.clear();
+}
+
+Drivers::Slot::~Slot()
+{
+    if (!m_driver.empty()) {
+        Drivers::instance().release(m_driver, m_stateDir);
+    }
+}
+
+const std::string& Drivers::Slot::stateDir() const
+{
+    return m_stateDir;
+}
+
+// =====================================================================================================================
+
+Drivers& Drivers::instance()
+{
+    static Drivers inst;
+    return inst;
+}
+
+Drivers::Drivers()
+{
+    for (const auto& driver : Known) {
+        if (auto found = find(driver); !found.empty()) {
+            m_drivers[driver].driver = driver;
+            m_drivers[driver].path   = found;
+            log_debug("Driver %s: %s", driver.c_str(), found.c_str());
+        }
+    }
+}
+
+Drivers::~Drivers()
+{
+    std::error_code ec;
+    for (const auto& dir : m_stateDirs) {
+        std::filesystem::remove_all(dir, ec);
+    }
+}
+
+std::string Drivers::find(const std::string& driver) const
+{
+    for (const auto& path : Paths) {
+        auto check = path / driver;
+        if (access(check.c_str(), X_OK) == 0) {
+            return check.string();
+        }
+    }
+    return {};
+}
+
+Expected<std::string> Drivers::path(const std::string& driver)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (auto it = m_drivers.find(driver); it != m_drivers.end() && !it->second.path.empty()) {
+        return it->second.path;
+    }
+
+    // Not found ones are probed again, driver could be installed after start
+    if (auto found = find(driver); !found.empty()) {
+        m_drivers[driver].driver = driver;
+        m_drivers[driver].path   = found;
+        return found;
+    }
+    return unexpected("Executable {} was not found", driver);
+}
+
+Expected<Drivers::Slot> Drivers::acquire(const std::string& driver, int milliseconds)
+{
+    uint32_t limit = std::max(1u, Config::instance().driverJobs.value());
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto&                        stat = m_drivers[driver];
+    stat.driver                       = driver;
+
+    auto free = [&]() {
+        return stat.running < limit;
+    };
+    if (milliseconds < 0) {
+        m_released.wait(lock, free);
+    } else if (!m_released.wait_for(lock, std::chrono::milliseconds(milliseconds), free)) {
+        return unexpected("Request timed out, {} instances of {} are running", limit, driver);
+    }
+    ++stat.running;
+
+    std::string stateDir;
+    if (!m_stateDirs.empty()) {
+        stateDir = m_stateDirs.back();
+        m_stateDirs.pop_back();
+    } else {
+        lock.unlock();
+        char tmpl[] = "/tmp/nutXXXXXX";
+        if (auto temp = mkdtemp(tmpl)) {
+            stateDir = temp;
+        } else {
+            lock.lock();
+            --stat.running;
+            m_released.notify_one();
+            return unexpected("Cannot create state directory: {}", strerror(errno));
+        }
+    }
+    return Slot(driver, stateDir);
+}
+
+void Drivers::release(const std::string& driver, const std::string& stateDir)
+{
+    // Leftovers of the run (pid files, sockets) are dropped, directory itself is kept for the next one
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(stateDir, ec)) {
+        std::filesystem::remove_all(entry.path(), ec);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (std::filesystem::exists(stateDir, ec)) {
+        m_stateDirs.push_back(stateDir);
+    }
+    --m_drivers[driver].running;
+    m_released.notify_all();
+}
+
+void Drivers::spawned(const std::string& driver, std::chrono::microseconds latency)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto&                       stat = m_drivers[driver];
+    ++stat.spawns;
+    stat.spawnTotal += latency;
+    stat.spawnMax = std::max(stat.spawnMax, latency);
+}
+
+std::vector<Drivers::Stat> Drivers::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Stat>           ret;
+    for (const auto& [_, stat] : m_drivers) {
+        ret.push_back(stat);
+    }
+    return ret;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl::nut
@@ -0,0 +1,100 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <fty/expected.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fty::impl::nut {
+
+// =====================================================================================================================
+
+/// NUT drivers runner state.
+/// Executable paths are resolved once, state directories are reused between runs and number of running instances of
+/// each driver is bounded, so batch onboarding does not pay filesystem probing and does not flood the system by
+/// drivers. Spawn latency of every driver is measured.
+class Drivers
+{
+public:
+    /// Run of one driver: state directory and place in the driver limit, both are given back on destruction
+    class Slot
+    {
+    public:
+        Slot(Slot&& other);
+        ~Slot();
+
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+        Slot& operator=(Slot&&) = delete;
+
+        /// State directory (NUT_STATEPATH) of the run, empty on start
+        const std::string& stateDir() const;
+
+    private:
+        friend class Drivers;
+        Slot(const std::string& driver, const std::string& stateDir);
+
+    private:
+        std::string m_driver;
+        std::string m_stateDir;
+    };
+
+    struct Stat
+    {
+        std::string               driver;
+        std::string               path;
+        uint32_t                  running = 0;
+        uint32_t                  spawns  = 0;
+        std::chrono::microseconds spawnTotal{0};
+        std::chrono::microseconds spawnMax{0};
+    };
+
+public:
+    static Drivers& instance();
+    ~Drivers();
+
+    /// Returns path of driver executable
+    Expected<std::string> path(const std::string& driver);
+
+    /// Takes a slot of the driver, waits at most given time (-1 is infinite) if all of them are taken
+    Expected<Slot> acquire(const std::string& driver, int milliseconds = -1);
+
+    /// Records spawn latency of the driver
+    void spawned(const std::string& driver, std::chrono::microseconds latency);
+
+    /// Statistics of all drivers which were used or found
+    std::vector<Stat> stats() const;
+
+private:
+    Drivers();
+    void        release(const std::string& driver, const std::string& stateDir);
+    std::string find(const std::string& driver) const;
+
+private:
+    mutable std::mutex          m_mutex;
+    std::condition_variable     m_released;
+    std::map<std::string, Stat> m_drivers;
+    std::vector<std::string>    m_stateDirs;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl::nut
@@ -0,0 +1,129 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "dump.h"
+#include "mapper.h"
+#include <algorithm>
+#include <charconv>
+
+namespace fty::impl::nut {
+
+// =====================================================================================================================
+
+/// Splits "key: value" line, key is made of [a-z0-9.], colon is followed by at least one space
+static bool split(std::string_view line, std::string_view& key, std::string_view& value)
+{
+    auto isKey = [](char ch) {
+        return (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') || ch == '.';
+    };
+    auto isSpace = [](char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\v' || ch == '\f';
+    };
+
+    size_t pos = 0;
+    while (pos < line.size() && isKey(line[pos])) {
+        ++pos;
+    }
+    if (pos == 0) {
+        return false;
+    }
+    key = line.substr(0, pos);
+
+    while (pos < line.size() && isSpace(line[pos])) {
+        ++pos;
+    }
+    if (pos == line.size() || line[pos] != ':') {
+        return false;
+    }
+
+    size_t start = ++pos;
+    while (pos < line.size() && isSpace(line[pos])) {
+        ++pos;
+    }
+    if (pos == start) {
+        return false;
+    }
+    value = line.substr(pos);
+    return true;
+}
+
+bool Dump::add(std::string_view line)
+{
+    std::string_view key;
+    std::string_view value;
+    if (!split(line, key, value)) {
+        return true;
+    }
+
+    if (key == "device.count") {
+        // Malformed count is not a daisy chain, it must not break reading of the dump
+        int count = 0;
+        std::from_chars(value.data(), value.data() + value.size(), count);
+        m_daisy = count > 1;
+    }
+
+    // Sorted dump is just appended, the first of repeated keys is kept
+    if (m_values.empty() || key > m_values.back().key) {
+        m_values.push_back({std::string(key), std::string(value)});
+    } else {
+        auto it = std::lower_bound(m_values.begin(), m_values.end(), key, [](const Value& val, std::string_view k) {
+            return val.key < k;
+        });
+        if (it->key != key) {
+            // Unsorted dump is read to the end
+            m_sorted = false;
+            m_values.insert(it, {std::string(key), std::string(value)});
+        }
+    }
+
+    if (!m_sorted) {
+        return true;
+    }
+
+    // Daisy chain devices are described by "device.N." keys which are sorted before device.count and device.type,
+    // single device needs everything up to the last mapped key
+    static const std::string single = std::max<std::string>(Mapper::lastKey(), "device.type");
+    return key <= (m_daisy ? std::string_view("device.type") : std::string_view(single));
+}
+
+void Dump::parse(const std::string& content)
+{
+    std::string_view view(content);
+    for (auto pos = view.find('\n'); !view.empty(); pos = view.find('\n')) {
+        add(view.substr(0, pos));
+        view.remove_prefix(pos == std::string_view::npos ? view.size() : pos + 1);
+    }
+}
+
+const Dump::Values& Dump::values() const
+{
+    return m_values;
+}
+
+std::optional<std::string_view> Dump::value(std::string_view key) const
+{
+    auto it = std::lower_bound(m_values.begin(), m_values.end(), key, [](const Value& val, std::string_view k) {
+        return val.key < k;
+    });
+    if (it != m_values.end() && it->key == key) {
+        return std::string_view(it->value);
+    }
+    return std::nullopt;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl::nut
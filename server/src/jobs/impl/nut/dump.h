@@ -0,0 +1,63 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fty::impl::nut {
+
+// =====================================================================================================================
+
+/// Driver dump ("key: value" per line) collected while the driver is still running.
+/// Drivers dump their state sorted by key, so once a key past every key discovery uses has arrived, the rest of the
+/// dump is not needed and the driver can be stopped.
+class Dump
+{
+public:
+    struct Value
+    {
+        std::string key;
+        std::string value;
+    };
+
+    /// Values sorted by key
+    using Values = std::vector<Value>;
+
+public:
+    /// Adds one line of the dump, returns false if the rest of the dump is not needed
+    bool add(std::string_view line);
+
+    /// Adds the whole dump
+    void parse(const std::string& content);
+
+    /// Collected values
+    const Values& values() const;
+
+    /// Value of the key
+    std::optional<std::string_view> value(std::string_view key) const;
+
+private:
+    Values m_values;
+    bool   m_sorted = true;
+    bool   m_daisy  = false;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl::nut
@@ -0,0 +1,202 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "inventory.h"
+#include "src/config.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fty_log.h>
+#include <map>
+#include <pack/pack.h>
+#include <vector>
+
+namespace fty::impl::nut {
+
+// =====================================================================================================================
+
+/// One row of mib2nut table: NUT variable and the object it is read from
+class InventoryValue : public pack::Node
+{
+public:
+    pack::String key   = FIELD("key");
+    pack::String oid   = FIELD("oid");     // numeric OID, "%i" is replaced by index of daisy chained device
+    pack::String value = FIELD("default"); // static value, or value used if object cannot be read
+
+public:
+    using pack::Node::Node;
+    META(InventoryValue, key, oid, value);
+};
+
+/// Inventory part of one mib2nut table
+class InventoryMib : public pack::Node
+{
+public:
+    pack::String                     name   = FIELD("name");         // NUT mib name
+    pack::String                     count  = FIELD("count");        // OID of number of daisy chained devices
+    pack::Int32                      offset = FIELD("index-offset"); // added to device number to get its index
+    pack::ObjectList<InventoryValue> values = FIELD("values");
+
+public:
+    using pack::Node::Node;
+    META(InventoryMib, name, count, offset, values);
+};
+
+class InventoryFile : public pack::Node
+{
+public:
+    pack::ObjectList<InventoryMib> mibs = FIELD("mibs");
+
+public:
+    using pack::Node::Node;
+    META(InventoryFile, mibs);
+};
+
+struct Inventory::Tables
+{
+    std::map<std::string, InventoryMib> mibs;
+};
+
+// =====================================================================================================================
+
+/// Number of daisy chained devices is either a number or a list of device indexes ("0,1,2,3")
+static size_t deviceCount(const std::string& value)
+{
+    if (value.find(',') != std::string::npos) {
+        return size_t(std::count(value.begin(), value.end(), ',')) + 1;
+    }
+    return std::strtoul(value.c_str(), nullptr, 10);
+}
+
+// =====================================================================================================================
+
+Inventory::Inventory()
+    : m_tables(new Tables)
+{
+    InventoryFile file;
+    if (auto ret = pack::yaml::deserializeFile(Config::instance().nutInventory.value(), file); !ret) {
+        log_warning("Cannot load NUT inventory tables: %s, assets are read by NUT drivers", ret.error().c_str());
+        return;
+    }
+
+    for (const auto& mib : file.mibs) {
+        m_tables->mibs.emplace(mib.name.value(), mib);
+    }
+    log_info("Loaded NUT inventory tables of %zu mibs", m_tables->mibs.size());
+}
+
+Inventory::~Inventory() = default;
+
+Inventory& Inventory::instance()
+{
+    static Inventory inst;
+    return inst;
+}
+
+bool Inventory::supports(const std::string& mib) const
+{
+    return m_tables->mibs.count(mib) > 0;
+}
+
+Expected<std::string> Inventory::read(const snmp::Session& session, const std::string& mib) const
+{
+    auto it = m_tables->mibs.find(mib);
+    if (it == m_tables->mibs.end()) {
+        return unexpected("Mib {} is not described by NUT inventory tables", mib);
+    }
+    const InventoryMib& table = it->second;
+
+    size_t count = 1;
+    if (!table.count.empty()) {
+        if (auto cnt = session.read(table.count.value())) {
+            count = std::max<size_t>(1, deviceCount(*cnt));
+        }
+    }
+
+    // Daisy chained devices are printed with "device.N." prefix, like the driver does
+    struct Line
+    {
+        std::string key;
+        std::string value;
+        size_t      oid;
+    };
+
+    static constexpr size_t NoOid = size_t(-1);
+
+    std::vector<Line>             lines;
+    std::vector<std::string>      oids;
+    std::map<std::string, size_t> oidIndex;
+
+    auto add = [&](const std::string& key, const InventoryValue& row, size_t dev) {
+        if (row.oid.empty()) {
+            lines.push_back({key, row.value.value(), NoOid});
+            return;
+        }
+
+        std::string oid = row.oid.value();
+        if (auto pos = oid.find("%i"); pos != std::string::npos) {
+            oid.replace(pos, 2, std::to_string(int(dev) + table.offset.value()));
+        }
+        auto [idx, inserted] = oidIndex.emplace(oid, oids.size());
+        if (inserted) {
+            oids.push_back(oid);
+        }
+        lines.push_back({key, row.value.value(), idx->second});
+    };
+
+    for (const auto& row : table.values) {
+        if (count == 1 || row.oid.empty()) {
+            add(row.key.value(), row, 1);
+        }
+    }
+    if (count > 1) {
+        lines.push_back({"device.count", std::to_string(count), NoOid});
+        for (size_t dev = 1; dev <= count; ++dev) {
+            for (const auto& row : table.values) {
+                // "device.model" of the first device is "device.1.model", "outlet.count" is "device.1.outlet.count"
+                std::string key = row.key.value();
+                if (key.find("device.") == 0) {
+                    key = key.substr(7);
+                }
+                add(fmt::format("device.{}.{}", dev, key), row, dev);
+            }
+        }
+    }
+
+    // All objects of all devices are packed in as few requests as possible
+    auto values = session.read(oids);
+
+    size_t      answered = 0;
+    std::string out;
+    for (const auto& line : lines) {
+        std::string value = line.value;
+        if (line.oid != NoOid && values[line.oid] && !values[line.oid]->empty()) {
+            value = *values[line.oid];
+            ++answered;
+        }
+        if (!value.empty()) {
+            out += line.key + ": " + value + "\n";
+        }
+    }
+
+    if (!oids.empty() && !answered) {
+        return unexpected("Device did not answer any inventory object of {}", mib);
+    }
+    return out;
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl::nut
@@ -0,0 +1,52 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "src/jobs/impl/snmp.h"
+#include <fty/expected.h>
+#include <memory>
+#include <string>
+
+namespace fty::impl::nut {
+
+// =====================================================================================================================
+
+/// Reads inventory of snmp-ups driver in process.
+/// Values are described by the inventory part of NUT mib2nut tables (see nut/inventory.yaml), the result is the same
+/// "key: value" dump the driver prints, without spawning it and loading all its MIBs for a few dozen objects.
+class Inventory
+{
+public:
+    static Inventory& instance();
+    ~Inventory();
+
+    /// Checks if NUT mib (legacy name) is described by the tables
+    bool supports(const std::string& mib) const;
+
+    /// Reads inventory of the device by opened session, fails if device does not answer any object
+    Expected<std::string> read(const snmp::Session& session, const std::string& mib) const;
+
+private:
+    Inventory();
+
+private:
+    struct Tables;
+    std::unique_ptr<Tables> m_tables;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl::nut
@@ -15,11 +15,11 @@
 */
 
 #include "mapper.h"
+#include <algorithm>
 #include <fstream>
 #include <fty/string-utils.h>
 #include <fty_log.h>
 #include <pack/pack.h>
-#include <regex>
 
 
 namespace fty::impl::nut {
@@ -51,22 +51,50 @@ struct Mappping : public pack::Node
 
 std::string Mapper::mapKey(const std::string& key)
 {
-    static std::regex rerex("#");
-    static std::regex rex("(.*\\.)(\\d+)(\\..*)");
+    auto& map = mapping();
 
-    auto&       map = mapping();
-    std::smatch matches;
-    if (std::regex_match(key, matches, rex)) {
-        std::string num  = matches.str(2);
-        std::string repl = std::regex_replace(key, rex, "$1#$3");
+    // Numbered keys ("outlet.12.current") are mapped by the last all-digit part which is not the last one of the key
+    // ("outlet.#.current"), placeholders of the mapped key are replaced back by the number
+    for (size_t end = key.rfind('.'); end != std::string::npos && end > 0; end = key.rfind('.', end - 1)) {
+        size_t begin = key.rfind('.', end - 1);
+        if (begin == std::string::npos) {
+            break;
+        }
+        ++begin;
+        auto isDigit = [](char ch) {
+            return ch >= '0' && ch <= '9';
+        };
+        if (begin == end || !std::all_of(key.begin() + long(begin), key.begin() + long(end), isDigit)) {
+            continue;
+        }
 
-        if (auto mapped = map.map(repl); !mapped.empty()) {
-            return std::regex_replace(mapped, rerex, num);
+        std::string num = key.substr(begin, end - begin);
+        if (auto mapped = map.map(key.substr(0, begin) + "#" + key.substr(end)); !mapped.empty()) {
+            for (auto pos = mapped.find('#'); pos != std::string::npos; pos = mapped.find('#', pos + num.size())) {
+                mapped.replace(pos, 1, num);
+            }
+            return mapped;
         }
+        break;
     }
     return map.map(key);
 }
 
+const std::string& Mapper::lastKey()
+{
+    static std::string last = [] {
+        std::string ret;
+        for (const auto& [key, _] : mapping().inventoryMapping) {
+            // '~' sorts after any digit, so placeholder stands for the greatest number
+            std::string bound = key;
+            std::replace(bound.begin(), bound.end(), '#', '~');
+            ret = std::max(ret, bound);
+        }
+        return ret;
+    }();
+    return last;
+}
+
 const Mappping& Mapper::mapping()
 {
     static Mappping mapping;
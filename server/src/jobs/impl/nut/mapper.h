@@ -28,6 +28,9 @@ class Mapper
 public:
     static std::string mapKey(const std::string& key);
 
+    /// Greatest driver key which can be mapped, numbered keys ("outlet.#.name") are counted with any number
+    static const std::string& lastKey();
+
 private:
     static const Mappping& mapping();
 };
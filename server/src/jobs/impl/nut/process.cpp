@@ -1,31 +1,20 @@
 #include "process.h"
+#include "drivers.h"
 #include "src/config.h"
 #include "src/jobs/impl/mibs.h"
-#include <filesystem>
-#include <fty/process.h>
-#include <fty_common_socket_sync_client.h>
+#include "src/jobs/impl/wallet.h"
+#include <algorithm>
+#include <chrono>
 #include <fty_log.h>
 #include <fty_security_wallet.h>
-#include <unistd.h>
 
 namespace fty::impl::nut {
 Process::Process(const std::string& protocol)
     : m_protocol(protocol)
 {
-    char tmpl[] = "/tmp/nutXXXXXX";
-    if (auto temp = mkdtemp(tmpl)) {
-        m_root = temp;
-    } else {
-        m_root = "/tmp/nut";
-    }
 }
 
-Process::~Process()
-{
-    if (std::filesystem::exists(m_root)) {
-        std::filesystem::remove_all(m_root);
-    }
-}
+Process::~Process() = default;
 
 Expected<void> Process::setupSnmp(const std::string& address, uint16_t port)
 {
@@ -35,15 +24,15 @@ Expected<void> Process::setupSnmp(const std::string& address, uint16_t port)
 
     std::string toconnect = fmt::format("{}:{}", address, port);
 
-    if (auto path = findExecutable("snmp-ups")) {
+    m_driver = "snmp-ups";
+    if (auto path = Drivers::instance().path(m_driver)) {
         // clang-format off
-        m_process = std::unique_ptr<fty::Process>(new fty::Process(*path, {
+        m_process = std::unique_ptr<ChildProcess>(new ChildProcess(*path, {
             "-s", "discover",
             "-x", fmt::format("port={}", toconnect),
             "-d", "1"
         }));
         // clang-format on
-        m_process->setEnvVar("NUT_STATEPATH", m_root);
         m_process->setEnvVar("MIBDIRS", Config::instance().mibDatabase);
         return {};
     } else {
@@ -63,15 +52,15 @@ Expected<void> Process::setupXmlPdc(const std::string& address, uint16_t port)
         toconnect = "http://" + toconnect;
     }
 
-    if (auto path = findExecutable("netxml-ups")) {
+    m_driver = "netxml-ups";
+    if (auto path = Drivers::instance().path(m_driver)) {
         // clang-format off
-        m_process = std::unique_ptr<fty::Process>(new fty::Process(*path, {
+        m_process = std::unique_ptr<ChildProcess>(new ChildProcess(*path, {
             "-s", "discover",
             "-x", fmt::format("port={}", toconnect),
             "-d", "1"
         }));
         // clang-format on
-        m_process->setEnvVar("NUT_STATEPATH", m_root);
         return {};
     } else {
         return unexpected(path.error());
@@ -80,9 +69,10 @@ Expected<void> Process::setupXmlPdc(const std::string& address, uint16_t port)
 
 Expected<void> Process::setupPowercom(const std::string& address)
 {
-    if (auto path = findExecutable("etn-nut-powerconnect")) {
+    m_driver = "etn-nut-powerconnect";
+    if (auto path = Drivers::instance().path(m_driver)) {
         // clang-format off
-        m_process = std::unique_ptr<fty::Process>(new fty::Process(*path, {
+        m_process = std::unique_ptr<ChildProcess>(new ChildProcess(*path, {
             "-x", fmt::format("port={}", address),
             "-d", "1"
         }));
@@ -115,20 +105,6 @@ Expected<void> Process::init(const std::string& address, uint16_t port)
     return {};
 }
 
-Expected<std::string> Process::findExecutable(const std::string& name) const
-{
-    static std::vector<std::filesystem::path> paths = {"/usr/lib/nut", "/lib/nut", "/home/jes/workspace/fty/build/Debug/deps-runtime/bin"};
-
-    for (const auto& path : paths) {
-        auto check = path / name;
-        if (std::filesystem::exists(check) && access(check.c_str(), X_OK) == 0) {
-            return (path / name).string();
-        }
-    }
-
-    return unexpected("Executable {} was not found", name);
-}
-
 Expected<void> Process::setCredentialId(const std::string& credential)
 {
     if (!m_process) {
@@ -136,9 +112,6 @@ Expected<void> Process::setCredentialId(const std::string& credential)
     }
 
     if (m_protocol == "nut_snmp") {
-        fty::SocketSyncClient secwSyncClient("/run/fty-security-wallet/secw.socket");
-        auto                  client = secw::ConsumerAccessor(secwSyncClient);
-
         auto levelStr = [](secw::Snmpv3SecurityLevel lvl) -> Expected<std::string> {
             switch (lvl) {
                 case secw::NO_AUTH_NO_PRIV:
@@ -177,10 +150,13 @@ Expected<void> Process::setCredentialId(const std::string& credential)
             return unexpected("Wrong protocol");
         };
 
-        try {
-            auto secCred = client.getDocumentWithPrivateData("default", credential);
+        auto secCred = Wallet::instance().document(credential);
+        if (!secCred) {
+            return unexpected(secCred.error());
+        }
 
-            if (auto credV3 = secw::Snmpv3::tryToCast(secCred)) {
+        try {
+            if (auto credV3 = secw::Snmpv3::tryToCast(*secCred)) {
                 log_debug("Init from wallet for snmp v3");
                 
                 m_process->setEnvVar("SU_VAR_VERSION", "v3");
@@ -214,7 +190,7 @@ Expected<void> Process::setCredentialId(const std::string& credential)
                     m_process->addArgument("-x");
                     m_process->addArgument(fmt::format("privProtocol={}", *prot));
                 }
-            } else if (auto credV1 = secw::Snmpv1::tryToCast(secCred)) {
+            } else if (auto credV1 = secw::Snmpv1::tryToCast(*secCred)) {
                 log_debug("Init from wallet for snmp v1");
                 setCommunity(credV1->getCommunityName());
             } else {
@@ -224,12 +200,13 @@ Expected<void> Process::setCredentialId(const std::string& credential)
             return unexpected(err.what());
         }
     } else if (m_protocol == "nut_powercom") {
-        fty::SocketSyncClient secwSyncClient("/run/fty-security-wallet/secw.socket");
-        auto                  client = secw::ConsumerAccessor(secwSyncClient);
+        auto secCred = Wallet::instance().document(credential);
+        if (!secCred) {
+            return unexpected(secCred.error());
+        }
 
         try {
-            auto secCred = client.getDocumentWithPrivateData("default", credential);
-            if (auto cred = secw::UserAndPassword::tryToCast(secCred)) {
+            if (auto cred = secw::UserAndPassword::tryToCast(*secCred)) {
                 m_process->addArgument("-x");
                 m_process->addArgument(fmt::format("username={}", cred->getUsername()));
 
@@ -305,24 +282,53 @@ Expected<void> Process::setMib(const std::string& mib)
     return {};
 }
 
-Expected<std::string> Process::run() const
+Expected<void> Process::run(ChildProcess::LineFunc&& func, int milliseconds) const
 {
-    if (auto pid = m_process->run()) {
-        if (auto stat = m_process->wait(); *stat == 0) {
-            return m_process->readAllStandardOutput();
+    using Clock = std::chrono::steady_clock;
+
+    if (!m_process) {
+        return unexpected("uninitialized");
+    }
+
+    // Driver waits for a free slot no longer than the requester waits for the answer
+    auto waiting = Clock::now();
+    auto slot    = Drivers::instance().acquire(m_driver, milliseconds);
+    if (!slot) {
+        return unexpected(slot.error());
+    }
+    if (milliseconds >= 0) {
+        auto waited  = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - waiting).count();
+        milliseconds = std::max(0, milliseconds - int(waited));
+    }
+
+    const auto& conf = Config::instance();
+    m_process->setEnvVar("NUT_STATEPATH", slot->stateDir());
+    m_process->setLimits(conf.driverCpu.value(), uint64_t(conf.driverMemory.value()) * 1024 * 1024);
+
+    auto spawning = Clock::now();
+    if (auto started = m_process->start(); !started) {
+        log_error("Run error: %s", started.error().c_str());
+        return unexpected(started.error());
+    }
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - spawning);
+    Drivers::instance().spawned(m_driver, latency);
+    log_debug("Driver %s spawned in %lld us", m_driver.c_str(), static_cast<long long>(latency.count()));
+
+    auto stat = m_process->read(std::move(func), milliseconds);
+    if (!stat) {
+        log_error("Driver %s is not finished (%s), killed it", m_protocol.c_str(), stat.error().c_str());
+        return unexpected(stat.error());
+    }
+    if (*stat != 0) {
+        const std::string& stdError = m_process->errors();
+        // workaround with nut_powercom: Test first if the credentials are correct
+        if (m_protocol == "nut_powercom" && stdError.find("Error when get client token on") != std::string::npos) {
+            return unexpected("Bad login or password");
         } else {
-            std::string stdError = m_process->readAllStandardError();
-            // workaround with nut_powercom: Test first if the credentials are correct
-            if (m_protocol == "nut_powercom" && stdError.find("Error when get client token on") != std::string::npos) {
-                return unexpected("Bad login or password");
-            } else {
-                return unexpected(stdError);
-            }
+            return unexpected(stdError);
         }
-    } else {
-        log_error("Run error: %s", pid.error().c_str());
-        return unexpected(pid.error());
     }
+    return {};
 }
 
 } // namespace fty::impl::nut
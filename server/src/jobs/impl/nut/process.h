@@ -1,10 +1,7 @@
 #pragma once
+#include "child-process.h"
 #include <fty/expected.h>
 
-namespace fty {
-class Process;
-}
-
 namespace fty::impl::nut {
 
 class Process
@@ -13,24 +10,25 @@ public:
     Process(const std::string& protocol);
     ~Process();
 
-    Expected<void>        init(const std::string& address, uint16_t port = 0);
-    Expected<void>        setCredentialId(const std::string& credential);
-    Expected<void>        setCredential(const std::string& userName, const std::string& password);
-    Expected<void>        setCommunity(const std::string& community);
-    Expected<void>        setTimeout(uint milliseconds);
-    Expected<void>        setMib(const std::string& mib);
-    Expected<std::string> run() const;
+    Expected<void> init(const std::string& address, uint16_t port = 0);
+    Expected<void> setCredentialId(const std::string& credential);
+    Expected<void> setCredential(const std::string& userName, const std::string& password);
+    Expected<void> setCommunity(const std::string& community);
+    Expected<void> setTimeout(uint milliseconds);
+    Expected<void> setMib(const std::string& mib);
+
+    /// Runs the driver, its dump is handed over line by line, callback returning false stops the driver
+    Expected<void> run(ChildProcess::LineFunc&& func, int milliseconds = -1) const;
 
 private:
-    Expected<std::string> findExecutable(const std::string& name) const;
     Expected<void> setupSnmp(const std::string& address, uint16_t port);
     Expected<void> setupXmlPdc(const std::string& address, uint16_t port);
     Expected<void> setupPowercom(const std::string& address);
 
 private:
     std::string                   m_protocol;
-    std::string                   m_root;
-    std::unique_ptr<fty::Process> m_process;
+    std::string                   m_driver;
+    std::unique_ptr<ChildProcess> m_process;
 };
 
 } // namespace fty::protocol::nut
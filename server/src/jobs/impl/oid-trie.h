@@ -0,0 +1,107 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Prefix tree on numeric object ids, finds value of the longest known prefix in O(length of oid)
+template <typename T>
+class OidTrie
+{
+public:
+    OidTrie()
+        : m_nodes(1)
+    {
+    }
+
+    /// Sets value of the prefix
+    void insert(const uint32_t* oid, size_t len, T value)
+    {
+        uint32_t node = 0;
+        for (size_t i = 0; i < len; ++i) {
+            auto& children = m_nodes[node].children;
+            auto  it       = lowerBound(children, oid[i]);
+            if (it == children.end() || it->id != oid[i]) {
+                uint32_t next = uint32_t(m_nodes.size());
+                children.insert(it, {oid[i], next});
+                m_nodes.emplace_back();
+                node = next;
+            } else {
+                node = it->node;
+            }
+        }
+        m_nodes[node].value = std::move(value);
+    }
+
+    /// Returns value of the longest prefix of oid, nullptr if no prefix is known
+    const T* find(const uint32_t* oid, size_t len) const
+    {
+        const T* found = nullptr;
+        uint32_t node  = 0;
+        for (size_t i = 0; i < len; ++i) {
+            const auto& children = m_nodes[node].children;
+            auto        it       = lowerBound(children, oid[i]);
+            if (it == children.end() || it->id != oid[i]) {
+                break;
+            }
+            node = it->node;
+            if (m_nodes[node].value) {
+                found = &*m_nodes[node].value;
+            }
+        }
+        return found;
+    }
+
+    bool empty() const
+    {
+        return m_nodes.size() == 1 && !m_nodes[0].value;
+    }
+
+private:
+    struct Child
+    {
+        uint32_t id;
+        uint32_t node;
+    };
+
+    struct Node
+    {
+        std::vector<Child> children; // sorted by id
+        std::optional<T>   value;
+    };
+
+    template <typename Children>
+    static auto lowerBound(Children& children, uint32_t id)
+    {
+        return std::lower_bound(children.begin(), children.end(), id, [](const Child& child, uint32_t val) {
+            return child.id < val;
+        });
+    }
+
+private:
+    std::vector<Node> m_nodes; // first one is root
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -15,49 +15,14 @@
 */
 
 #pragma once
-#include <errno.h>
-#include <netdb.h>
+#include "reachability.h"
 #include <string>
-#include <string.h>
-#include <unistd.h>
 
 // =====================================================================================================================
 
 inline bool available(const std::string& address)
 {
-    static std::string httpPrefix = "http://";
-
-    std::string checkAddress = address;
-    if (checkAddress.find(httpPrefix) == 0) {
-        checkAddress = checkAddress.substr(httpPrefix.size());
-    }
-
-    addrinfo hints;
-    memset(&hints, 0, sizeof(addrinfo));
-
-    hints.ai_family   = AF_UNSPEC;
-    hints.ai_socktype = SOCK_DGRAM;
-    hints.ai_flags    = 0;
-    hints.ai_protocol = 0;
-
-    addrinfo* result;
-    if (getaddrinfo(checkAddress.c_str(), nullptr, &hints, &result) != 0) {
-        return false;
-    }
-
-    bool ret = false;
-    for (addrinfo* rp = result; rp != nullptr; rp = rp->ai_next) {
-        int sock = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
-        if (sock == -1) {
-            continue;
-        }
-        if (connect(sock, rp->ai_addr, rp->ai_addrlen) != -1) {
-            ret = true;
-        }
-        close(sock);
-    }
-    freeaddrinfo(result);
-
-    return ret;}
+    return fty::impl::Reachability::instance().available(address);
+}
 
 // =====================================================================================================================
@@ -0,0 +1,494 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "reachability.h"
+#include "src/config.h"
+#include <algorithm>
+#include <array>
+#include <arpa/inet.h>
+#include <condition_variable>
+#include <deque>
+#include <fty_log.h>
+#include <future>
+#include <netdb.h>
+#include <netinet/icmp6.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <poll.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Ports used for TCP probe: connection accepted or refused (RST) both mean that host is alive
+static constexpr uint16_t TcpPorts[] = {80, 443};
+
+/// Max number of hosts probed at once, keeps number of opened sockets reasonable
+static constexpr size_t MaxBatch = 256;
+
+struct Address
+{
+    sockaddr_storage addr;
+    socklen_t        len = 0;
+};
+
+struct Reachability::Target
+{
+    std::string          address;
+    std::vector<Address> addrs;
+    bool                 reachable = false;
+};
+
+static std::string hostName(const std::string& address)
+{
+    static std::string httpPrefix = "http://";
+
+    if (address.find(httpPrefix) == 0) {
+        return address.substr(httpPrefix.size());
+    }
+    return address;
+}
+
+static std::vector<Address> getAddrInfo(const std::string& host, int flags)
+{
+    addrinfo hints;
+    memset(&hints, 0, sizeof(addrinfo));
+
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags    = flags;
+
+    std::vector<Address> ret;
+
+    addrinfo* result;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0) {
+        return ret;
+    }
+    for (addrinfo* rp = result; rp != nullptr; rp = rp->ai_next) {
+        Address& addr = ret.emplace_back();
+        memcpy(&addr.addr, rp->ai_addr, rp->ai_addrlen);
+        addr.len = rp->ai_addrlen;
+    }
+    freeaddrinfo(result);
+    return ret;
+}
+
+static bool sameHost(const sockaddr_storage& left, const sockaddr_storage& right)
+{
+    if (left.ss_family != right.ss_family) {
+        return false;
+    }
+    if (left.ss_family == AF_INET) {
+        return reinterpret_cast<const sockaddr_in&>(left).sin_addr.s_addr ==
+               reinterpret_cast<const sockaddr_in&>(right).sin_addr.s_addr;
+    }
+    if (left.ss_family == AF_INET6) {
+        return memcmp(&reinterpret_cast<const sockaddr_in6&>(left).sin6_addr,
+                   &reinterpret_cast<const sockaddr_in6&>(right).sin6_addr, sizeof(in6_addr)) == 0;
+    }
+    return false;
+}
+
+static uint16_t checksum(const void* data, size_t len)
+{
+    auto     buf = static_cast<const uint8_t*>(data);
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        sum += uint32_t(buf[i] << 8 | buf[i + 1]);
+    }
+    if (len % 2) {
+        sum += uint32_t(buf[len - 1] << 8);
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return htons(uint16_t(~sum));
+}
+
+// =====================================================================================================================
+// Resolver thread pool
+// =====================================================================================================================
+
+class Reachability::Resolver
+{
+public:
+    explicit Resolver(size_t threads)
+    {
+        for (size_t i = 0; i < threads; ++i) {
+            m_threads.emplace_back(&Resolver::worker, this);
+        }
+    }
+
+    ~Resolver()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        for (auto& th : m_threads) {
+            th.join();
+        }
+    }
+
+    std::shared_future<std::vector<Address>> resolve(const std::string& host)
+    {
+        // Numeric addresses do not need resolver
+        if (auto addrs = getAddrInfo(host, AI_NUMERICHOST); !addrs.empty()) {
+            std::promise<std::vector<Address>> ready;
+            ready.set_value(addrs);
+            return ready.get_future().share();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& item = m_queue.emplace_back(host, std::promise<std::vector<Address>>());
+        m_cond.notify_one();
+        return item.second.get_future().share();
+    }
+
+private:
+    void worker()
+    {
+        while (true) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [&]() {
+                return m_stop || !m_queue.empty();
+            });
+            if (m_stop) {
+                return;
+            }
+            auto [host, promise] = std::move(m_queue.front());
+            m_queue.pop_front();
+            lock.unlock();
+
+            promise.set_value(getAddrInfo(host, 0));
+        }
+    }
+
+private:
+    using Request = std::pair<std::string, std::promise<std::vector<Address>>>;
+
+    std::mutex               m_mutex;
+    std::condition_variable  m_cond;
+    std::deque<Request>      m_queue;
+    bool                     m_stop = false;
+    std::vector<std::thread> m_threads;
+};
+
+// =====================================================================================================================
+// ICMP echo socket
+// =====================================================================================================================
+
+class IcmpSocket
+{
+public:
+    explicit IcmpSocket(int family)
+        : m_family(family)
+    {
+        int proto = family == AF_INET ? int(IPPROTO_ICMP) : int(IPPROTO_ICMPV6);
+        // Unprivileged ping socket first (net.ipv4.ping_group_range), then raw one if we have CAP_NET_RAW
+        m_fd = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, proto);
+        if (m_fd == -1) {
+            m_fd  = socket(family, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, proto);
+            m_raw = true;
+        }
+    }
+
+    ~IcmpSocket()
+    {
+        if (m_fd != -1) {
+            close(m_fd);
+        }
+    }
+
+    int fd() const
+    {
+        return m_fd;
+    }
+
+    void send(const Address& addr, uint16_t seq)
+    {
+        if (m_fd == -1 || addr.addr.ss_family != m_family) {
+            return;
+        }
+
+        std::array<uint8_t, 16> packet{};
+        if (m_family == AF_INET) {
+            auto hdr              = reinterpret_cast<icmphdr*>(packet.data());
+            hdr->type             = ICMP_ECHO;
+            hdr->un.echo.id       = htons(uint16_t(getpid()));
+            hdr->un.echo.sequence = htons(seq);
+            hdr->checksum         = checksum(packet.data(), packet.size());
+        } else {
+            auto hdr        = reinterpret_cast<icmp6_hdr*>(packet.data());
+            hdr->icmp6_type = ICMP6_ECHO_REQUEST;
+            hdr->icmp6_id   = htons(uint16_t(getpid()));
+            hdr->icmp6_seq  = htons(seq);
+        }
+        sendto(m_fd, packet.data(), packet.size(), 0, reinterpret_cast<const sockaddr*>(&addr.addr), addr.len);
+    }
+
+    /// Reads all pending echo replies, calls func with source address of every reply
+    template <typename Func>
+    void receive(Func&& func)
+    {
+        std::array<uint8_t, 1500> buff;
+        sockaddr_storage          from;
+        while (true) {
+            socklen_t fromLen = sizeof(from);
+            ssize_t   len = recvfrom(m_fd, buff.data(), buff.size(), 0, reinterpret_cast<sockaddr*>(&from), &fromLen);
+            if (len <= 0) {
+                return;
+            }
+
+            size_t offset = 0;
+            if (m_raw && m_family == AF_INET) {
+                offset = size_t(reinterpret_cast<const iphdr*>(buff.data())->ihl) * 4;
+            }
+            if (size_t(len) < offset + 1) {
+                continue;
+            }
+
+            uint8_t type = buff[offset];
+            if ((m_family == AF_INET && type == ICMP_ECHOREPLY) || (m_family == AF_INET6 && type == ICMP6_ECHO_REPLY)) {
+                func(from);
+            }
+        }
+    }
+
+private:
+    int  m_family;
+    int  m_fd  = -1;
+    bool m_raw = false;
+};
+
+// =====================================================================================================================
+// Reachability
+// =====================================================================================================================
+
+Reachability::Reachability()
+    : m_resolver(new Resolver(std::max<size_t>(1, Config::instance().resolverThreads)))
+{
+}
+
+Reachability::~Reachability() = default;
+
+Reachability& Reachability::instance()
+{
+    static Reachability inst;
+    return inst;
+}
+
+bool Reachability::available(const std::string& address)
+{
+    return available(std::vector<std::string>{address})[address];
+}
+
+std::map<std::string, bool> Reachability::available(const std::vector<std::string>& addresses)
+{
+    std::map<std::string, bool> ret;
+    std::vector<Target>         targets;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto                        now = Clock::now();
+        for (const auto& address : addresses) {
+            if (auto it = m_cache.find(address); it != m_cache.end() && it->second.expire > now) {
+                ret[address] = it->second.reachable;
+            } else if (!ret.count(address)) {
+                ret[address] = false;
+                targets.push_back({address, {}, false});
+            }
+        }
+    }
+
+    auto timeout = std::chrono::milliseconds(Config::instance().reachabilityTimeout);
+    for (size_t start = 0; start < targets.size(); start += MaxBatch) {
+        auto                first = targets.begin() + long(start);
+        std::vector<Target> batch(first, first + long(std::min(MaxBatch, targets.size() - start)));
+        probe(batch, Clock::now() + timeout);
+
+        auto ttl = std::chrono::seconds(Config::instance().reachabilityCacheTtl);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto                        expire = Clock::now() + ttl;
+        for (const auto& target : batch) {
+            ret[target.address]     = target.reachable;
+            m_cache[target.address] = {target.reachable, expire};
+        }
+    }
+
+    return ret;
+}
+
+void Reachability::invalidate(const std::string& address)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (address.empty()) {
+        m_cache.clear();
+    } else {
+        m_cache.erase(address);
+    }
+}
+
+void Reachability::probe(std::vector<Target>& targets, Clock::time_point deadline)
+{
+    std::vector<std::shared_future<std::vector<Address>>> resolving;
+    for (const auto& target : targets) {
+        resolving.push_back(m_resolver->resolve(hostName(target.address)));
+    }
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (resolving[i].wait_until(deadline) == std::future_status::ready) {
+            targets[i].addrs = resolving[i].get();
+        } else {
+            log_debug("Cannot resolve %s in time", targets[i].address.c_str());
+        }
+    }
+
+    struct TcpProbe
+    {
+        int    fd;
+        size_t target;
+    };
+
+    IcmpSocket            icmp4(AF_INET);
+    IcmpSocket            icmp6(AF_INET6);
+    std::vector<TcpProbe> tcp;
+    size_t                pending = 0;
+
+    auto canPing = [&](const Address& addr) {
+        return (addr.addr.ss_family == AF_INET ? icmp4 : icmp6).fd() != -1;
+    };
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        auto& target = targets[i];
+        if (target.addrs.empty()) {
+            continue;
+        }
+
+        // Host which does not listen on probed TCP ports could be told from a dead one by ICMP only
+        if (std::none_of(target.addrs.begin(), target.addrs.end(), canPing)) {
+            static std::once_flag warned;
+            std::call_once(warned, []() {
+                log_warning("Cannot open ICMP socket, hosts are not checked for reachability");
+            });
+            target.reachable = true;
+            continue;
+        }
+        ++pending;
+
+        for (const auto& addr : target.addrs) {
+            icmp4.send(addr, uint16_t(i));
+            icmp6.send(addr, uint16_t(i));
+
+            for (uint16_t port : TcpPorts) {
+                Address dest = addr;
+                if (dest.addr.ss_family == AF_INET) {
+                    reinterpret_cast<sockaddr_in&>(dest.addr).sin_port = htons(port);
+                } else {
+                    reinterpret_cast<sockaddr_in6&>(dest.addr).sin6_port = htons(port);
+                }
+
+                int fd = socket(dest.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+                if (fd == -1) {
+                    continue;
+                }
+                if (connect(fd, reinterpret_cast<const sockaddr*>(&dest.addr), dest.len) == 0 ||
+                    errno == ECONNREFUSED) {
+                    target.reachable = true;
+                    close(fd);
+                } else if (errno == EINPROGRESS) {
+                    tcp.push_back({fd, i});
+                } else {
+                    close(fd);
+                }
+            }
+        }
+        if (target.reachable) {
+            --pending;
+        }
+    }
+
+    auto markReachable = [&](size_t idx) {
+        if (!targets[idx].reachable) {
+            targets[idx].reachable = true;
+            --pending;
+        }
+    };
+
+    auto onEcho = [&](const sockaddr_storage& from) {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            for (const auto& addr : targets[i].addrs) {
+                if (sameHost(addr.addr, from)) {
+                    markReachable(i);
+                }
+            }
+        }
+    };
+
+    std::vector<pollfd> fds;
+    while (pending > 0) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (left <= 0) {
+            break;
+        }
+
+        fds.clear();
+        fds.push_back({icmp4.fd(), POLLIN, 0});
+        fds.push_back({icmp6.fd(), POLLIN, 0});
+        for (const auto& item : tcp) {
+            // Probes of already reachable hosts are not interesting anymore
+            fds.push_back({targets[item.target].reachable ? -1 : item.fd, POLLOUT, 0});
+        }
+
+        if (poll(fds.data(), fds.size(), int(left)) <= 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            icmp4.receive(onEcho);
+        }
+        if (fds[1].revents & POLLIN) {
+            icmp6.receive(onEcho);
+        }
+        for (size_t i = 0; i < tcp.size(); ++i) {
+            if (!fds[i + 2].revents) {
+                continue;
+            }
+            int       err = 0;
+            socklen_t len = sizeof(err);
+            if (getsockopt(tcp[i].fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && (err == 0 || err == ECONNREFUSED)) {
+                markReachable(tcp[i].target);
+            }
+            // Host or network unreachable, wait for other probes
+            close(tcp[i].fd);
+            tcp[i].fd = -1;
+        }
+    }
+
+    for (const auto& item : tcp) {
+        if (item.fd != -1) {
+            close(item.fd);
+        }
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -0,0 +1,74 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Checks if hosts are reachable.
+/// Names are resolved by a small resolver thread pool, then ICMP echo and TCP SYN probes are sent to all hosts of the
+/// batch at once and answers are collected by one poll loop until the deadline. Verdicts are cached for a short time,
+/// so protocols, mibs and assets requests for the same host do not repeat the work.
+/// Without ICMP sockets (no CAP_NET_RAW and gid outside of net.ipv4.ping_group_range) hosts cannot be checked and are
+/// reported as available.
+class Reachability
+{
+public:
+    static Reachability& instance();
+    ~Reachability();
+
+    /// Checks one host
+    bool available(const std::string& address);
+
+    /// Checks list of hosts in batches, returns verdict for every address
+    std::map<std::string, bool> available(const std::vector<std::string>& addresses);
+
+    /// Forgets cached verdict of the address, or all verdicts if address is empty
+    void invalidate(const std::string& address);
+
+private:
+    Reachability();
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Verdict
+    {
+        bool              reachable = false;
+        Clock::time_point expire;
+    };
+
+    class Resolver;
+    struct Target;
+
+    void probe(std::vector<Target>& targets, Clock::time_point deadline);
+
+private:
+    std::unique_ptr<Resolver>      m_resolver;
+    std::mutex                     m_mutex;
+    std::map<std::string, Verdict> m_cache;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -0,0 +1,137 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "result-cache.h"
+#include "src/config.h"
+#include <fmt/format.h>
+#include <functional>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Credential material is identified by its hash, so secrets are not kept in cache keys
+static std::string fingerprint(const std::string& secret)
+{
+    return secret.empty() ? std::string() : fmt::format("{:016x}", std::hash<std::string>{}(secret));
+}
+
+std::string ResultCache::key(const std::string& subject, const commands::protocols::In& in)
+{
+    return fmt::format("{}|{}|{}", subject, in.address.value(), fingerprint("community:" + in.community.value()));
+}
+
+std::string ResultCache::key(const std::string& subject, const commands::mibs::In& in)
+{
+    auto credential = in.credentialId.hasValue() ? "credential:" + in.credentialId.value()
+                                                 : "community:" + in.community.value();
+    return fmt::format("{}|{}|{}|{}", subject, in.address.value(), in.port.value(), fingerprint(credential));
+}
+
+std::string ResultCache::key(const std::string& subject, const commands::assets::In& in)
+{
+    const auto& settings   = in.settings;
+    auto        credential = settings.credentialId.hasValue() ? "credential:" + settings.credentialId.value()
+                                                              : "community:" + settings.community.value();
+    if (settings.username.hasValue()) {
+        credential += "|user:" + settings.username.value() + ":" + settings.password.value();
+    }
+    return fmt::format("{}|{}|{}|{}|{}|{}", subject, in.address.value(), in.port.value(), in.protocol.value(),
+        fingerprint(credential), settings.mib.value());
+}
+
+ResultCache& ResultCache::instance()
+{
+    static ResultCache inst;
+    return inst;
+}
+
+size_t ResultCache::invalidate(const std::string& address)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t removed = 0;
+    if (address.empty()) {
+        for (const auto& it : m_results) {
+            removed += it.second.size();
+        }
+        m_results.clear();
+    } else if (auto it = m_results.find(address); it != m_results.end()) {
+        removed = it->second.size();
+        m_results.erase(it);
+    }
+    return removed;
+}
+
+std::optional<std::string> ResultCache::find(const std::string& address, const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto device = m_results.find(address);
+    if (device == m_results.end()) {
+        return std::nullopt;
+    }
+
+    auto it = device->second.find(key);
+    if (it == device->second.end()) {
+        return std::nullopt;
+    }
+
+    if (it->second.expire < std::chrono::steady_clock::now()) {
+        device->second.erase(it);
+        if (device->second.empty()) {
+            m_results.erase(device);
+        }
+        return std::nullopt;
+    }
+    return it->second.result;
+}
+
+void ResultCache::store(const std::string& address, const std::string& key, const std::string& result)
+{
+    auto ttl = std::chrono::seconds(Config::instance().resultCacheTtl.value());
+    if (ttl.count() == 0) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto sweep = [&](std::map<std::string, Entry>& results) {
+        for (auto it = results.begin(); it != results.end();) {
+            it = it->second.expire < now ? results.erase(it) : std::next(it);
+        }
+    };
+
+    auto& results = m_results[address];
+    sweep(results);
+    results[key] = {result, now + ttl};
+
+    // Expired results of other devices are dropped once per time to live, so cache does not grow with every scanned
+    // address and a put does not walk the whole cache
+    if (now - m_swept >= ttl) {
+        m_swept = now;
+        for (auto device = m_results.begin(); device != m_results.end();) {
+            sweep(device->second);
+            device = device->second.empty() ? m_results.erase(device) : std::next(device);
+        }
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -0,0 +1,86 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "commands.h"
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <pack/pack.h>
+#include <string>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Results of protocols, mibs and assets requests.
+/// Results are keyed by subject and the request fields which change the result (address, port, protocol, credential or
+/// community, mib), so the same wizard step for the same device is answered without touching the network until the
+/// result expires. Timeouts do not change the result, secrets are kept only as a fingerprint.
+class ResultCache
+{
+public:
+    static ResultCache& instance();
+
+    /// Fills output by cached result of the request, returns false if there is none or cache is bypassed
+    template <typename InT, typename OutT>
+    bool get(const std::string& subject, const InT& in, OutT& out)
+    {
+        if (in.bypassCache.value()) {
+            return false;
+        }
+        if (auto cached = find(in.address, key(subject, in))) {
+            return bool(pack::json::deserialize(*cached, out));
+        }
+        return false;
+    }
+
+    /// Stores result of the request
+    template <typename InT, typename OutT>
+    void put(const std::string& subject, const InT& in, const OutT& out)
+    {
+        if (auto json = pack::json::serialize(out)) {
+            store(in.address, key(subject, in), *json);
+        }
+    }
+
+    /// Drops results of the address, or all results if address is empty, returns number of dropped results
+    size_t invalidate(const std::string& address);
+
+private:
+    struct Entry
+    {
+        std::string                           result;
+        std::chrono::steady_clock::time_point expire;
+    };
+
+    static std::string key(const std::string& subject, const commands::protocols::In& in);
+    static std::string key(const std::string& subject, const commands::mibs::In& in);
+    static std::string key(const std::string& subject, const commands::assets::In& in);
+
+    std::optional<std::string> find(const std::string& address, const std::string& key);
+    void                       store(const std::string& address, const std::string& key, const std::string& result);
+
+private:
+    std::mutex                                          m_mutex;
+    std::map<std::string, std::map<std::string, Entry>> m_results; // address -> request -> result
+    std::chrono::steady_clock::time_point               m_swept = std::chrono::steady_clock::now();
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -0,0 +1,284 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "snmp-probe.h"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <netdb.h>
+#include <poll.h>
+#include <random>
+#include <string.h>
+#include <unistd.h>
+
+namespace fty::impl::snmp {
+
+// =====================================================================================================================
+// BER encoding
+// =====================================================================================================================
+
+namespace ber {
+
+    enum Tag : uint8_t
+    {
+        Integer     = 0x02,
+        OctetString = 0x04,
+        Null        = 0x05,
+        ObjectId    = 0x06,
+        Sequence    = 0x30,
+        GetRequest  = 0xa0,
+        GetResponse = 0xa2,
+        Report      = 0xa8
+    };
+
+    static std::string tlv(uint8_t tag, const std::string& value)
+    {
+        std::string out(1, char(tag));
+        size_t      len = value.size();
+        if (len < 0x80) {
+            out += char(len);
+        } else if (len <= 0xff) {
+            out += char(0x81);
+            out += char(len);
+        } else {
+            out += char(0x82);
+            out += char(len >> 8);
+            out += char(len & 0xff);
+        }
+        return out + value;
+    }
+
+    static std::string integer(int32_t value)
+    {
+        std::string out;
+        auto        uval = uint32_t(value);
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out += char((uval >> shift) & 0xff);
+        }
+        // Minimal two's complement form
+        while (out.size() > 1 && ((out[0] == 0 && !(out[1] & 0x80)) || (out[0] == char(0xff) && (out[1] & 0x80)))) {
+            out.erase(0, 1);
+        }
+        return tlv(Integer, out);
+    }
+
+    static std::string octets(const std::string& value)
+    {
+        return tlv(OctetString, value);
+    }
+
+    static std::string sequence(const std::string& value)
+    {
+        return tlv(Sequence, value);
+    }
+
+    /// Reads one TLV, returns tag and moves pos to the value
+    static std::optional<std::pair<uint8_t, size_t>> read(const std::string& msg, size_t& pos)
+    {
+        if (pos + 2 > msg.size()) {
+            return std::nullopt;
+        }
+        uint8_t tag = uint8_t(msg[pos++]);
+        size_t  len = uint8_t(msg[pos++]);
+        if (len & 0x80) {
+            size_t bytes = len & 0x7f;
+            if (bytes == 0 || bytes > 4 || pos + bytes > msg.size()) {
+                return std::nullopt;
+            }
+            len = 0;
+            for (size_t i = 0; i < bytes; ++i) {
+                len = (len << 8) | uint8_t(msg[pos++]);
+            }
+        }
+        if (pos + len > msg.size()) {
+            return std::nullopt;
+        }
+        return std::make_pair(tag, len);
+    }
+
+    static std::optional<int32_t> readInteger(const std::string& msg, size_t& pos)
+    {
+        auto tlv = read(msg, pos);
+        if (!tlv || tlv->first != Integer || tlv->second == 0 || tlv->second > 4) {
+            return std::nullopt;
+        }
+        int32_t value = int8_t(msg[pos]);
+        for (size_t i = 1; i < tlv->second; ++i) {
+            value = int32_t(uint32_t(value) << 8 | uint8_t(msg[pos + i]));
+        }
+        pos += tlv->second;
+        return value;
+    }
+
+} // namespace ber
+
+// =====================================================================================================================
+
+namespace probe {
+
+    std::string encodeGet(Version version, const std::string& community, int32_t requestId)
+    {
+        // RFC1213-MIB::sysObjectID.0 (1.3.6.1.2.1.1.2.0)
+        static const std::string sysObjectId =
+            ber::tlv(ber::ObjectId, std::string("\x2b\x06\x01\x02\x01\x01\x02\x00", 8));
+        static const std::string null = ber::tlv(ber::Null, "");
+
+        std::string varbinds = ber::sequence(ber::sequence(sysObjectId + null));
+        std::string pdu =
+            ber::tlv(ber::GetRequest, ber::integer(requestId) + ber::integer(0) + ber::integer(0) + varbinds);
+        return ber::sequence(ber::integer(int32_t(version)) + ber::octets(community) + pdu);
+    }
+
+    std::string encodeDiscovery(int32_t msgId)
+    {
+        static constexpr int32_t MaxSize        = 65507;
+        static constexpr char    Reportable     = 0x04;
+        static constexpr int32_t UsmSecurityMod = 3;
+
+        std::string global = ber::sequence(ber::integer(msgId) + ber::integer(MaxSize) +
+            ber::octets(std::string(1, Reportable)) + ber::integer(UsmSecurityMod));
+        std::string security = ber::octets(ber::sequence(ber::octets("") + ber::integer(0) + ber::integer(0) +
+            ber::octets("") + ber::octets("") + ber::octets("")));
+        std::string pdu =
+            ber::tlv(ber::GetRequest, ber::integer(msgId) + ber::integer(0) + ber::integer(0) + ber::sequence(""));
+        std::string scoped = ber::sequence(ber::octets("") + ber::octets("") + pdu);
+        return ber::sequence(ber::integer(int32_t(Version::V3)) + global + security + scoped);
+    }
+
+    std::optional<int32_t> responseId(const std::string& message)
+    {
+        size_t pos = 0;
+        if (auto msg = ber::read(message, pos); !msg || msg->first != ber::Sequence) {
+            return std::nullopt;
+        }
+
+        auto version = ber::readInteger(message, pos);
+        if (!version) {
+            return std::nullopt;
+        }
+
+        if (*version == int32_t(Version::V3)) {
+            if (auto global = ber::read(message, pos); !global || global->first != ber::Sequence) {
+                return std::nullopt;
+            }
+            return ber::readInteger(message, pos);
+        }
+
+        if (auto community = ber::read(message, pos); !community || community->first != ber::OctetString) {
+            return std::nullopt;
+        } else {
+            pos += community->second;
+        }
+
+        if (auto pdu = ber::read(message, pos); !pdu || (pdu->first != ber::GetResponse && pdu->first != ber::Report)) {
+            return std::nullopt;
+        }
+        return ber::readInteger(message, pos);
+    }
+
+} // namespace probe
+
+// =====================================================================================================================
+
+Expected<void> tryAgent(const std::string& address, uint16_t port, const std::string& community,
+    std::chrono::milliseconds timeout, const std::atomic_bool& cancelled)
+{
+    using Clock = std::chrono::steady_clock;
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(addrinfo));
+
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+
+    addrinfo* addrInfo;
+    if (int ret = getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &addrInfo); ret != 0) {
+        return unexpected(gai_strerror(ret));
+    }
+    std::unique_ptr<addrinfo, decltype(&freeaddrinfo)> addrInfoPtr(addrInfo, &freeaddrinfo);
+
+    int sock = socket(addrInfo->ai_family, addrInfo->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, addrInfo->ai_protocol);
+    if (sock == -1) {
+        return unexpected(strerror(errno));
+    }
+    std::unique_ptr<int, void (*)(int*)> sockPtr(&sock, [](int* fd) {
+        close(*fd);
+    });
+
+    // Connected socket gets ICMP port unreachable as ECONNREFUSED, so closed port is detected immediately
+    if (connect(sock, addrInfo->ai_addr, addrInfo->ai_addrlen) != 0) {
+        return unexpected(strerror(errno));
+    }
+
+    thread_local std::mt19937              gen{std::random_device{}()};
+    std::uniform_int_distribution<int32_t> dist(1, std::numeric_limits<int32_t>::max());
+    std::array<int32_t, 3>                 ids      = {dist(gen), dist(gen), dist(gen)};
+    std::array<std::string, 3>             requests = {
+        probe::encodeGet(probe::Version::V2c, community, ids[0]),
+        probe::encodeGet(probe::Version::V1, community, ids[1]),
+        probe::encodeDiscovery(ids[2]),
+    };
+
+    auto sendAll = [&]() {
+        for (const auto& req : requests) {
+            [[maybe_unused]] auto res = send(sock, req.data(), req.size(), 0);
+        }
+    };
+
+    auto deadline = Clock::now() + timeout;
+    auto resend   = Clock::now() + timeout / 2;
+    sendAll();
+
+    std::array<char, 1500> buff;
+    while (!cancelled) {
+        auto now = Clock::now();
+        if (now >= deadline) {
+            return unexpected("timeout");
+        }
+        if (now >= resend) {
+            sendAll();
+            resend = deadline;
+        }
+
+        // Short slices, so cancellation is not noticed too late
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(std::min(deadline, resend) - now).count();
+        pollfd pfd = {sock, POLLIN, 0};
+        if (poll(&pfd, 1, int(std::min<long>(left + 1, 100))) <= 0) {
+            continue;
+        }
+
+        ssize_t len = recv(sock, buff.data(), buff.size(), 0);
+        if (len < 0) {
+            if (errno == ECONNREFUSED) {
+                return unexpected("port is closed");
+            }
+            continue;
+        }
+
+        if (auto id = probe::responseId(std::string(buff.data(), size_t(len)))) {
+            if (std::find(ids.begin(), ids.end(), *id) != ids.end()) {
+                return {};
+            }
+        }
+    }
+    return unexpected("cancelled");
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl::snmp
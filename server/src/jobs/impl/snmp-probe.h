@@ -0,0 +1,57 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <fty/expected.h>
+#include <optional>
+#include <string>
+
+namespace fty::impl::snmp {
+
+// =====================================================================================================================
+
+/// Lightweight SNMP presence probe.
+/// Sends hand encoded GET of sysObjectID.0 (v2c and v1) and SNMPv3 engine discovery request from one non-blocking
+/// UDP socket and waits for any answer matching request id. No net-snmp session is involved.
+namespace probe {
+
+    enum class Version
+    {
+        V1  = 0,
+        V2c = 1,
+        V3  = 3
+    };
+
+    /// Encodes GET sysObjectID.0 message for v1/v2c
+    std::string encodeGet(Version version, const std::string& community, int32_t requestId);
+
+    /// Encodes SNMPv3 discovery message (no user, reportable), every v3 agent answers it with a report
+    std::string encodeDiscovery(int32_t msgId);
+
+    /// Returns request id (v1/v2c) or msgID (v3) of the message, nullopt if this is not an SNMP answer
+    std::optional<int32_t> responseId(const std::string& message);
+
+} // namespace probe
+
+/// Checks if SNMP agent answers on address:port
+Expected<void> tryAgent(const std::string& address, uint16_t port, const std::string& community,
+    std::chrono::milliseconds timeout, const std::atomic_bool& cancelled);
+
+// =====================================================================================================================
+
+} // namespace fty::impl::snmp
@@ -18,17 +18,37 @@
 // Config should be firt
 #include <net-snmp/net-snmp-config.h>
 // Snmp stuff
+#include <net-snmp/library/large_fd_set.h>
 #include <net-snmp/mib_api.h>
 #include <net-snmp/session_api.h>
 #include <net-snmp/snmpv3_api.h>
 // Other
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fcntl.h>
+#include <fty/event.h>
 #include <fty/expected.h>
-#include <fty_common_socket_sync_client.h>
 #include <fty_log.h>
 #include <fty_security_wallet.h>
+#include <future>
 #include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
 #include <regex>
 #include <set>
+#include <shared_mutex>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include "known-oids.h"
+#include "mib-snapshot.h"
+#include "mpsc-queue.h"
+#include "src/config.h"
+#include "wallet.h"
 
 namespace fty::impl {
 
@@ -77,6 +97,524 @@ static Expected<oid*> authPriv(secw::Snmpv3PrivProtocol proc)
     return unexpected("Wrong protocol");
 }
 
+// =====================================================================================================================
+// SNMP engine: single reactor thread which multiplexes all opened sessions
+// =====================================================================================================================
+
+namespace snmp {
+    /// Engine thread owns all net-snmp sessions, jobs submit work through a lock-free queue and wait for futures.
+    class Engine
+    {
+    public:
+        using Command = std::function<void()>;
+
+        static Engine& instance();
+        ~Engine();
+
+        /// Queues command to be executed in reactor thread (runs immediately if called from reactor thread).
+        void post(Command&& cmd);
+
+        /// Queues command to the next loop iteration even if called from reactor thread. Used for commands which must
+        /// not run inside net-snmp callbacks, like closing the session which is being read.
+        void defer(Command&& cmd);
+
+        /// Registers opened net-snmp session in reactor, must be called from reactor thread
+        void attach(void* handle);
+
+        /// Removes net-snmp session from reactor, must be called from reactor thread
+        void detach(void* handle);
+
+    private:
+        Engine();
+        void loop();
+        void wakeup();
+        void runCommands();
+
+    private:
+        MpscQueue<Command> m_commands;
+        std::set<void*>    m_sessions; // accessed only from reactor thread
+        std::atomic_bool   m_signalled = false;
+        std::atomic_bool   m_stop      = false;
+        int                m_wake[2]   = {-1, -1};
+        std::thread        m_thread;
+    };
+
+    Engine::Engine()
+    {
+        if (pipe2(m_wake, O_NONBLOCK | O_CLOEXEC) != 0) {
+            log_error("Snmp engine: cannot create wakeup pipe: %s", strerror(errno));
+        }
+        m_thread = std::thread(&Engine::loop, this);
+    }
+
+    Engine::~Engine()
+    {
+        m_stop = true;
+        wakeup();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        close(m_wake[0]);
+        close(m_wake[1]);
+    }
+
+    Engine& Engine::instance()
+    {
+        static Engine inst;
+        return inst;
+    }
+
+    void Engine::post(Command&& cmd)
+    {
+        if (std::this_thread::get_id() == m_thread.get_id()) {
+            cmd();
+            return;
+        }
+
+        defer(std::move(cmd));
+    }
+
+    void Engine::defer(Command&& cmd)
+    {
+        m_commands.push(std::move(cmd));
+        // Reactor runs queued commands at the start of every iteration, it has to be woken up only from other threads.
+        // Only the first command after the reactor drained the queue has to write to the wakeup pipe.
+        if (std::this_thread::get_id() != m_thread.get_id() && !m_signalled.exchange(true)) {
+            wakeup();
+        }
+    }
+
+    void Engine::attach(void* handle)
+    {
+        m_sessions.insert(handle);
+    }
+
+    void Engine::detach(void* handle)
+    {
+        m_sessions.erase(handle);
+    }
+
+    void Engine::wakeup()
+    {
+        char ch = 1;
+        [[maybe_unused]] auto res = write(m_wake[1], &ch, 1);
+    }
+
+    void Engine::runCommands()
+    {
+        m_signalled = false;
+        while (auto cmd = m_commands.pop()) {
+            (*cmd)();
+        }
+    }
+
+    void Engine::loop()
+    {
+        netsnmp_large_fd_set fds;
+        netsnmp_large_fd_set_init(&fds, FD_SETSIZE);
+
+        while (!m_stop) {
+            runCommands();
+
+            NETSNMP_LARGE_FD_ZERO(&fds);
+            NETSNMP_LARGE_FD_SET(m_wake[0], &fds);
+
+            int     numfds     = m_wake[0] + 1;
+            timeval timeout    = {0, 0};
+            bool    hasTimeout = false;
+
+            for (void* handle : m_sessions) {
+                int     block = 1;
+                timeval tv    = {0, 0};
+                snmp_sess_select_info2(handle, &numfds, &fds, &tv, &block);
+                if (!block && (!hasTimeout || timercmp(&tv, &timeout, <))) {
+                    timeout    = tv;
+                    hasTimeout = true;
+                }
+            }
+
+            int count = netsnmp_large_fd_set_select(numfds, &fds, nullptr, nullptr, hasTimeout ? &timeout : nullptr);
+            if (count < 0) {
+                if (errno != EINTR) {
+                    log_error("Snmp engine: select failed: %s", strerror(errno));
+                }
+                continue;
+            }
+
+            if (count > 0 && NETSNMP_LARGE_FD_ISSET(m_wake[0], &fds)) {
+                std::array<char, 64> buff;
+                while (read(m_wake[0], buff.data(), buff.size()) > 0) {
+                }
+            }
+
+            // Callbacks could close sessions, so iterate over a copy and skip already detached ones
+            std::vector<void*> sessions(m_sessions.begin(), m_sessions.end());
+            for (void* handle : sessions) {
+                if (count > 0 && m_sessions.count(handle)) {
+                    snmp_sess_read2(handle, &fds);
+                }
+                if (m_sessions.count(handle)) {
+                    snmp_sess_timeout(handle);
+                }
+            }
+        }
+
+        netsnmp_large_fd_set_cleanup(&fds);
+    }
+} // namespace snmp
+
+// =====================================================================================================================
+// Pool of opened sessions, keyed by address, port and credential
+// =====================================================================================================================
+
+namespace snmp {
+    class SessionPool
+    {
+    public:
+        static SessionPool& instance();
+        ~SessionPool();
+
+        /// Takes idle session opened with the same key, returns nullptr if there is none
+        void* acquire(const std::string& key);
+
+        /// Gives opened session back to the pool, must be called from reactor thread
+        void release(const std::string& key, void* handle);
+
+        /// Closes idle sessions opened with wallet credential
+        void drop(const std::string& credId);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Idle
+        {
+            std::string       key;
+            void*             handle;
+            Clock::time_point since;
+        };
+
+        SessionPool();
+
+        /// Closes expired sessions and least recently used ones over the limit, call with locked mutex
+        void evict(size_t maxSize);
+
+        /// Closes session in reactor thread, never inline
+        static void close(void* handle);
+
+    private:
+        std::mutex               m_mutex;
+        std::list<Idle>          m_idle; // most recently used first
+        Slot<const std::string&> m_walletSlot = {&SessionPool::drop, this};
+    };
+
+    SessionPool::SessionPool()
+    {
+        // Sessions are closed by engine, so it must outlive the pool
+        Engine::instance();
+        m_walletSlot.connect(Wallet::instance().changed);
+    }
+
+    SessionPool::~SessionPool()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        evict(0);
+    }
+
+    SessionPool& SessionPool::instance()
+    {
+        static SessionPool inst;
+        return inst;
+    }
+
+    void* SessionPool::acquire(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        evict(Config::instance().snmpPoolSize);
+
+        auto it = std::find_if(m_idle.begin(), m_idle.end(), [&](const Idle& idle) {
+            return idle.key == key;
+        });
+        if (it == m_idle.end()) {
+            return nullptr;
+        }
+
+        void* handle = it->handle;
+        m_idle.erase(it);
+        return handle;
+    }
+
+    void SessionPool::release(const std::string& key, void* handle)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idle.push_front({key, handle, Clock::now()});
+        evict(Config::instance().snmpPoolSize);
+    }
+
+    void SessionPool::drop(const std::string& credId)
+    {
+        std::string suffix = "|credential:" + credId;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_idle.begin(); it != m_idle.end();) {
+            if (it->key.size() >= suffix.size() &&
+                it->key.compare(it->key.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                close(it->handle);
+                it = m_idle.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void SessionPool::evict(size_t maxSize)
+    {
+        auto expired = Clock::now() - std::chrono::seconds(Config::instance().snmpPoolIdle);
+        while (!m_idle.empty() && (m_idle.size() > maxSize || m_idle.back().since < expired)) {
+            close(m_idle.back().handle);
+            m_idle.pop_back();
+        }
+    }
+
+    void SessionPool::close(void* handle)
+    {
+        // Session can be released from its own response callback, it is closed once net-snmp is done with it
+        Engine::instance().defer([handle]() {
+            Engine::instance().detach(handle);
+            snmp_sess_close(handle);
+        });
+    }
+} // namespace snmp
+
+// =====================================================================================================================
+// Cache of keys generated from SNMPv3 pass phrases
+// =====================================================================================================================
+
+namespace snmp {
+    /// Ku generation hashes 1 MB of pass phrase, so it is done once per credential and reused by all sessions.
+    /// Localised key (Kul) depends on engine id of the agent and is derived by net-snmp on session open.
+    class KeyCache
+    {
+    public:
+        static KeyCache& instance();
+
+        /// Returns key generated from pass phrase, regenerates it when protocol or pass phrase of credential changed
+        Expected<std::vector<u_char>> key(
+            const std::string& id, const oid* proto, size_t protoLen, const std::string& passPhrase);
+
+        /// Forgets keys of credential
+        void invalidate(const std::string& credId);
+
+    private:
+        KeyCache();
+
+        struct Entry
+        {
+            std::vector<oid>    proto;
+            std::string         passPhrase;
+            std::vector<u_char> key;
+        };
+
+        std::mutex                   m_mutex;
+        std::map<std::string, Entry> m_keys; // key: credential id and key purpose
+        Slot<const std::string&>     m_walletSlot = {&KeyCache::invalidate, this};
+    };
+
+    KeyCache::KeyCache()
+    {
+        m_walletSlot.connect(Wallet::instance().changed);
+    }
+
+    KeyCache& KeyCache::instance()
+    {
+        static KeyCache inst;
+        return inst;
+    }
+
+    Expected<std::vector<u_char>> KeyCache::key(
+        const std::string& id, const oid* proto, size_t protoLen, const std::string& passPhrase)
+    {
+        std::vector<oid> protocol(proto, proto + protoLen);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto                        it = m_keys.find(id);
+        if (it != m_keys.end() && it->second.proto == protocol && it->second.passPhrase == passPhrase) {
+            return it->second.key;
+        }
+
+        std::vector<u_char> key(USM_AUTH_KU_LEN);
+        size_t              keyLen = key.size();
+        auto                phrase = const_cast<u_char*>(reinterpret_cast<const u_char*>(passPhrase.c_str()));
+        if (generate_Ku(proto, u_int(protoLen), phrase, passPhrase.size(), key.data(), &keyLen) != SNMPERR_SUCCESS) {
+            return unexpected("Error generating Ku from pass phrase");
+        }
+        key.resize(keyLen);
+
+        m_keys[id] = {protocol, passPhrase, key};
+        return key;
+    }
+
+    void KeyCache::invalidate(const std::string& credId)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_keys.erase(credId + "/auth");
+        m_keys.erase(credId + "/priv");
+    }
+} // namespace snmp
+
+// =====================================================================================================================
+// Object names
+// =====================================================================================================================
+
+namespace snmp {
+    /// MIB tree of net-snmp is global and its parser is not thread safe
+    static std::mutex mibMutex;
+
+    /// Resolves object names, every name goes to MIB parser only once.
+    /// Fixed reads are resolved at compile time and numeric names are parsed in place.
+    class Resolver
+    {
+    public:
+        static Resolver& instance()
+        {
+            static Resolver inst;
+            return inst;
+        }
+
+        bool parse(const std::string& name, oid* out, size_t* len)
+        {
+            if (auto known = findKnownOid(name)) {
+                return assign(known->oid, known->oid + known->len, out, len);
+            }
+
+            if (!name.empty() && (name[0] == '.' || isdigit(name[0]))) {
+                return parseNumeric(name, out, len);
+            }
+
+            {
+                std::shared_lock<std::shared_mutex> lock(m_mutex);
+                if (auto it = m_resolved.find(name); it != m_resolved.end()) {
+                    return assign(it->second.begin(), it->second.end(), out, len);
+                }
+            }
+
+            std::vector<oid> resolved;
+            if (auto snap = Snmp::instance().snapshot()) {
+                auto parsed = snap->parse(name);
+                if (!parsed) {
+                    return false;
+                }
+                resolved.assign(parsed->begin(), parsed->end());
+            } else {
+                oid    buff[MAX_OID_LEN];
+                size_t buffLen = MAX_OID_LEN;
+
+                std::lock_guard<std::mutex> lock(mibMutex);
+                if (!snmp_parse_oid(name.c_str(), buff, &buffLen)) {
+                    return false;
+                }
+                resolved.assign(buff, buff + buffLen);
+            }
+
+            {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                if (m_resolved.size() >= MaxResolved) {
+                    m_resolved.clear();
+                }
+                m_resolved.emplace(name, resolved);
+            }
+            return assign(resolved.begin(), resolved.end(), out, len);
+        }
+
+    private:
+        static constexpr size_t MaxResolved = 4096;
+
+        template <typename It>
+        static bool assign(It begin, It end, oid* out, size_t* len)
+        {
+            size_t size = size_t(std::distance(begin, end));
+            if (size > *len) {
+                return false;
+            }
+            std::copy(begin, end, out);
+            *len = size;
+            return true;
+        }
+
+        static bool parseNumeric(const std::string& name, oid* out, size_t* len)
+        {
+            size_t count = 0;
+            size_t pos   = name[0] == '.' ? 1 : 0;
+            while (pos < name.size()) {
+                size_t next = name.find('.', pos);
+                if (next == std::string::npos) {
+                    next = name.size();
+                }
+                if (next == pos || count == *len) {
+                    return false;
+                }
+
+                oid val = 0;
+                for (size_t i = pos; i < next; ++i) {
+                    if (!isdigit(name[i])) {
+                        return false;
+                    }
+                    val = val * 10 + oid(name[i] - '0');
+                }
+                out[count++] = val;
+                pos          = next + 1;
+            }
+            *len = count;
+            return count > 0 && name.back() != '.';
+        }
+
+    private:
+        std::shared_mutex                                 m_mutex;
+        std::unordered_map<std::string, std::vector<oid>> m_resolved;
+    };
+
+    /// Resolves object name by MIB snapshot if it is loaded, by net-snmp otherwise
+    static bool parseOid(const std::string& name, oid* out, size_t* len)
+    {
+        return Resolver::instance().parse(name, out, len);
+    }
+
+    /// Prints object name by MIB snapshot if it is loaded, by net-snmp otherwise
+    static std::string printOid(const oid* name, size_t len)
+    {
+        if (auto snap = Snmp::instance().snapshot()) {
+            return snap->print(MibSnapshot::Oid(name, name + len));
+        }
+
+        std::array<char, 255> buff;
+
+        std::lock_guard<std::mutex> lock(mibMutex);
+        snprint_objid(buff.data(), buff.size(), name, len);
+        return buff.data();
+    }
+} // namespace snmp
+
+// =====================================================================================================================
+// Protocol version of community agents
+// =====================================================================================================================
+
+namespace snmp {
+    /// Agents which answered only SNMPv1 to a community session, later sessions to them do not try SNMPv2c again
+    static std::mutex            v1AgentsMutex;
+    static std::set<std::string> v1Agents;
+
+    static long communityVersion(const std::string& address)
+    {
+        std::lock_guard<std::mutex> lock(v1AgentsMutex);
+        return v1Agents.count(address) ? SNMP_VERSION_1 : SNMP_VERSION_2c;
+    }
+
+    static void setV1Agent(const std::string& address)
+    {
+        std::lock_guard<std::mutex> lock(v1AgentsMutex);
+        v1Agents.insert(address);
+    }
+} // namespace snmp
+
 // =====================================================================================================================
 // Session private implementation
 // =====================================================================================================================
@@ -84,6 +622,16 @@ static Expected<oid*> authPriv(secw::Snmpv3PrivProtocol proc)
 class snmp::Session::Impl
 {
 public:
+    using Callback   = std::function<void(const Expected<netsnmp_pdu*>&)>;
+    using PduBuilder = std::function<netsnmp_pdu*()>;
+
+    /// Initial and maximal number of objects asked by one GETBULK request of walk
+    static constexpr long BulkRepetitions    = 10;
+    static constexpr long BulkMaxRepetitions = 50;
+
+    /// Maximal number of variables in one GET request
+    static constexpr size_t MaxVarbinds = 32;
+
     Impl(const std::string& addr, uint16_t port)
         : m_addr(addr + ":" + std::to_string(port))
     {
@@ -92,32 +640,60 @@ public:
 
         m_sess.peername = const_cast<char*>(m_addr.c_str());
         m_sess.retries  = 1;
-        m_sess.timeout  = 500 * 1000; // 500 ms
+        m_sess.timeout  = long(DefaultTimeout.count()) * 1000;
     }
 
     virtual ~Impl()
     {
-        if (m_handle) {
-            snmp_sess_close(m_handle);
+        if (!m_handle) {
+            return;
         }
+
+        std::promise<void> closed;
+        Engine::instance().post([&]() {
+            if (m_pending.empty()) {
+                // Nothing in flight, session can be reused by the next request to the same device
+                SessionPool::instance().release(m_key, m_handle);
+            } else {
+                // Session is not read anymore, but it is closed only on the next loop iteration: destructor can run
+                // from a response callback of this very session, inside net-snmp read
+                void* handle = m_handle;
+                m_handle     = nullptr;
+                Engine::instance().detach(handle);
+                Engine::instance().defer([handle]() {
+                    snmp_sess_close(handle);
+                });
+                // Close leaves requests without answer, do not let anybody wait for it forever. Callbacks which send
+                // again fail fast on the closed session.
+                for (auto* req : std::set<Request*>(m_pending)) {
+                    finish(req, unexpected("Session closed"));
+                }
+            }
+            closed.set_value();
+        });
+        closed.get_future().wait();
     }
 
     Expected<void> setCommunity(const std::string& community)
     {
-        m_sess.version       = SNMP_VERSION_1;
-        m_sess.community     = const_cast<u_char*>(reinterpret_cast<const u_char*>(community.c_str()));
-        m_sess.community_len = strlen(reinterpret_cast<const char*>(m_sess.community));
+        m_community          = community;
+        m_credential         = "community:" + community;
+        m_sess.version       = communityVersion(m_addr);
+        m_sess.community     = const_cast<u_char*>(reinterpret_cast<const u_char*>(m_community.c_str()));
+        m_sess.community_len = m_community.size();
         return {};
     }
 
     Expected<void> setCredentialId(const std::string& credId)
     {
-        try {
-            fty::SocketSyncClient secwSyncClient("/run/fty-security-wallet/secw.socket");
-            auto                  client  = secw::ConsumerAccessor(secwSyncClient);
-            auto                  secCred = client.getDocumentWithPrivateData("default", credId);
+        m_credential = "credential:" + credId;
+        auto secCred = Wallet::instance().document(credId);
+        if (!secCred) {
+            return unexpected(secCred.error());
+        }
 
-            if (auto credV3 = secw::Snmpv3::tryToCast(secCred)) {
+        try {
+            if (auto credV3 = secw::Snmpv3::tryToCast(*secCred)) {
                 m_sess.version = SNMP_VERSION_3;
 
                 m_sess.securityName    = strdup(credV3->getSecurityName().c_str());
@@ -146,20 +722,23 @@ public:
                         m_sess.securityPrivProtoLen = sizeof(usmAESPrivProtocol) / sizeof(oid);
                 }
 
-                if (generate_Ku(m_sess.securityAuthProto, u_int(m_sess.securityAuthProtoLen),
-                        const_cast<u_char*>(reinterpret_cast<const u_char*>(credV3->getAuthPassword().c_str())),
-                        u_int(credV3->getAuthPassword().size()), m_sess.securityAuthKey,
-                        &m_sess.securityAuthKeyLen) != SNMPERR_SUCCESS) {
-                    log_error("Error generating Ku from authentication pass phrase.");
+                auto& keys = KeyCache::instance();
+                if (auto key = keys.key(credId + "/auth", m_sess.securityAuthProto, m_sess.securityAuthProtoLen,
+                        credV3->getAuthPassword())) {
+                    m_sess.securityAuthKeyLen = std::min(key->size(), sizeof(m_sess.securityAuthKey));
+                    memcpy(m_sess.securityAuthKey, key->data(), m_sess.securityAuthKeyLen);
+                } else {
+                    log_error("%s from authentication pass phrase.", key.error().c_str());
                 }
-                if (generate_Ku(m_sess.securityAuthProto, u_int(m_sess.securityAuthProtoLen),
-                        const_cast<u_char*>(reinterpret_cast<const u_char*>(credV3->getPrivPassword().c_str())),
-                        u_int(credV3->getPrivPassword().size()), m_sess.securityPrivKey,
-                        &m_sess.securityPrivKeyLen) != SNMPERR_SUCCESS) {
-                    log_error("Error generating Ku from privacy pass phrase.");
+                if (auto key = keys.key(credId + "/priv", m_sess.securityAuthProto, m_sess.securityAuthProtoLen,
+                        credV3->getPrivPassword())) {
+                    m_sess.securityPrivKeyLen = std::min(key->size(), sizeof(m_sess.securityPrivKey));
+                    memcpy(m_sess.securityPrivKey, key->data(), m_sess.securityPrivKeyLen);
+                } else {
+                    log_error("%s from privacy pass phrase.", key.error().c_str());
                 }
-            } else if (auto credV1 = secw::Snmpv1::tryToCast(secCred)) {
-                m_sess.version = SNMP_VERSION_1;
+            } else if (auto credV1 = secw::Snmpv1::tryToCast(*secCred)) {
+                m_sess.version = communityVersion(m_addr);
                 m_sess.community =
                     const_cast<u_char*>(reinterpret_cast<const u_char*>(strdup(credV1->getCommunityName().c_str())));
                 m_sess.community_len = credV1->getCommunityName().size();
@@ -178,95 +757,425 @@ public:
 
     Expected<void> open()
     {
-        m_handle = snmp_sess_open(&m_sess);
-        if (!m_handle) {
-            log_error("Snmp error: %s", snmp_api_errstring(snmp_errno));
-            return unexpected(snmp_api_errstring(snmp_errno));
+        m_key = m_addr + "|" + m_credential;
+        if (auto handle = SessionPool::instance().acquire(m_key)) {
+            m_handle = handle;
+            Engine::instance().post([handle, timeout = m_sess.timeout, retries = m_sess.retries]() {
+                snmp_sess_session(handle)->timeout = timeout;
+                snmp_sess_session(handle)->retries = retries;
+            });
+            return {};
         }
-        if (!snmp_sess_session(m_handle)) {
-            log_error("Snmp error: %s", snmp_api_errstring(snmp_errno));
-            return unexpected(snmp_api_errstring(snmp_errno));
+
+        // Opening touches global state of net-snmp (snmp_errno, transports, users), so it is done by engine thread
+        std::promise<Expected<void*>> opened;
+        Engine::instance().post([&]() {
+            void* handle = snmp_sess_open(&m_sess);
+            if (!handle || !snmp_sess_session(handle)) {
+                opened.set_value(unexpected(snmp_api_errstring(snmp_errno)));
+                return;
+            }
+            Engine::instance().attach(handle);
+            opened.set_value(handle);
+        });
+
+        auto handle = opened.get_future().get();
+        if (!handle) {
+            log_error("Snmp error: %s", handle.error().c_str());
+            return unexpected(handle.error());
         }
+        m_handle = *handle;
+        // Community agent could know SNMPv1 only, first request without answer tries it
+        m_probeVersion = m_sess.version == SNMP_VERSION_2c;
         return {};
     }
 
     Expected<std::string> read(const std::string& stroid)
+    {
+        std::promise<Expected<std::string>> promise;
+        read(stroid, [&](const Expected<std::string>& value) {
+            promise.set_value(value);
+        });
+        return promise.get_future().get();
+    }
+
+    void read(const std::string& stroid, ReadFunc&& then)
     {
         oid    name[MAX_OID_LEN];
         size_t nameLen = MAX_OID_LEN;
 
-        if (!snmp_parse_oid(stroid.c_str(), name, &nameLen)) {
-            return unexpected("Cannot parse OID '{}'", stroid);
+        if (!parseOid(stroid, name, &nameLen)) {
+            then(unexpected("Cannot parse OID '{}'", stroid));
+            return;
         }
 
-        netsnmp_pdu* pdu = snmp_pdu_create(SNMP_MSG_GET);
-        snmp_add_null_var(pdu, name, nameLen);
+        auto build = [objId = std::vector<oid>(name, name + nameLen)]() {
+            netsnmp_pdu* pdu = snmp_pdu_create(SNMP_MSG_GET);
+            snmp_add_null_var(pdu, objId.data(), objId.size());
+            return pdu;
+        };
 
-        netsnmp_pdu* response = nullptr;
-        int          status   = snmp_sess_synch_response(m_handle, pdu, &response);
-        std::unique_ptr<netsnmp_pdu, std::function<void(netsnmp_pdu*)>> rptr(response, [](netsnmp_pdu* p) {
-            snmp_free_pdu(p);
+        send(std::move(build), [this, then = std::move(then)](const Expected<netsnmp_pdu*>& response) {
+            then(value(response));
         });
+    }
 
-        if (status == STAT_SUCCESS) {
-            if (response->errstat == SNMP_ERR_NOERROR) {
-                if (response->variables->val_len > 0) {
-                    return readVal(response->variables);
-                } else {
-                    unexpected("Wrong value type");
-                }
-            } else {
-                return unexpected(snmp_errstring(int(response->errstat)));
+    std::vector<Expected<std::string>> read(const std::vector<std::string>& oids)
+    {
+        std::promise<std::vector<Expected<std::string>>> promise;
+        read(oids, [&](std::vector<Expected<std::string>>&& values) {
+            promise.set_value(std::move(values));
+        });
+        return promise.get_future().get();
+    }
+
+    void read(const std::vector<std::string>& oids, ValuesFunc&& then)
+    {
+        auto state  = std::make_shared<ReadState>();
+        state->then = std::move(then);
+        state->values.resize(oids.size(), Expected<std::string>(unexpected("No answer")));
+        state->names.resize(oids.size());
+
+        state->batches.emplace_back();
+        for (size_t i = 0; i < oids.size(); ++i) {
+            auto& name = state->names[i];
+            if (!parseOid(oids[i], name.name, &name.len)) {
+                state->values[i] = unexpected("Cannot parse OID '{}'", oids[i]);
+                continue;
             }
+            if (state->batches.back().size() == MaxVarbinds) {
+                state->batches.emplace_back();
+            }
+            state->batches.back().push_back(i);
         }
-        return unexpected(snmp_api_errstring(snmp_errno));
+
+        readNext(state);
     }
 
-    Expected<void> walk(std::function<void(const std::string&)>&& func)
+    Expected<void> walk(WalkFunc&& func)
     {
-        oid    name[MAX_OID_LEN];
-        size_t nameLen = MAX_OID_LEN;
+        std::promise<Expected<void>> promise;
+        walk(std::move(func), [&](const Expected<void>& result) {
+            promise.set_value(result);
+        });
+        return promise.get_future().get();
+    }
 
-        bool running = true;
-        if (!snmp_parse_oid(".1.3.6.1.2.1", name, &nameLen)) {
-            return unexpected("Cannot parse root OID '.1.3.6.1.2.1'");
+    void walk(WalkFunc&& func, DoneFunc&& then)
+    {
+        auto state = std::make_shared<WalkState>();
+        if (!parseOid(".1.3.6.1.2.1", state->name, &state->nameLen)) {
+            then(unexpected("Cannot parse root OID '.1.3.6.1.2.1'"));
+            return;
         }
 
-        std::array<char, 255> buff;
+        state->func = std::move(func);
+        state->then = std::move(then);
 
-        while (running) {
-            netsnmp_pdu* pdu = snmp_pdu_create(SNMP_MSG_GETNEXT);
-            snmp_add_null_var(pdu, name, nameLen);
+        walkNext(state);
+    }
 
-            netsnmp_pdu* response = nullptr;
-            int          status   = snmp_sess_synch_response(m_handle, pdu, &response);
-            std::unique_ptr<netsnmp_pdu, std::function<void(netsnmp_pdu*)>> rptr(response, [](netsnmp_pdu* p) {
-                snmp_free_pdu(p);
-            });
+private:
+    struct Request
+    {
+        Impl*      session;
+        PduBuilder build; // request is built again when it is resent by SNMPv1
+        Callback   callback;
+    };
+
+    struct Name
+    {
+        oid    name[MAX_OID_LEN];
+        size_t len = MAX_OID_LEN;
+    };
 
-            if (status == STAT_ERROR) {
-                return unexpected(snmp_errstring(snmp_errno));
+    using Batch = std::vector<size_t>;
+
+    /// Batched read in progress, owned by the request in flight
+    struct ReadState
+    {
+        std::vector<Expected<std::string>> values;
+        std::vector<Name>                  names;
+        std::deque<Batch>                  batches;
+        ValuesFunc                         then;
+    };
+
+    /// Walk in progress, owned by the request in flight
+    struct WalkState
+    {
+        oid    name[MAX_OID_LEN];
+        size_t nameLen     = MAX_OID_LEN;
+        bool   bulk        = true;
+        long   repetitions = BulkRepetitions;
+        long   ceiling     = BulkMaxRepetitions;
+
+        // Buffers are reused for every object, callback gets views to them
+        std::vector<uint32_t> objName  = std::vector<uint32_t>(MAX_OID_LEN);
+        std::vector<uint32_t> objValue = std::vector<uint32_t>(MAX_OID_LEN);
+
+        WalkFunc func;
+        DoneFunc then;
+    };
+
+    /// Sends the next batch of read, or delivers values if nothing is left
+    void readNext(const std::shared_ptr<ReadState>& state)
+    {
+        while (!state->batches.empty() && state->batches.front().empty()) {
+            state->batches.pop_front();
+        }
+        if (state->batches.empty()) {
+            state->then(std::move(state->values));
+            return;
+        }
+
+        Batch batch = std::move(state->batches.front());
+        state->batches.pop_front();
+
+        auto build = [state, batch]() {
+            netsnmp_pdu* pdu = snmp_pdu_create(SNMP_MSG_GET);
+            for (size_t idx : batch) {
+                snmp_add_null_var(pdu, state->names[idx].name, state->names[idx].len);
             }
-            if (status == STAT_SUCCESS && response->errstat == SNMP_ERR_NOERROR) {
-                for (auto vars = response->variables; vars; vars = vars->next_variable) {
-                    snprint_objid(buff.data(), buff.size(), vars->name, vars->name_length);
-                    func(buff.data());
-                    if ((vars->type != SNMP_ENDOFMIBVIEW) && (vars->type != SNMP_NOSUCHOBJECT) &&
-                        (vars->type != SNMP_NOSUCHINSTANCE)) {
-                        memmove(name, vars->name, vars->name_length * sizeof(oid));
-                        nameLen = vars->name_length;
-                    } else {
+            return pdu;
+        };
+
+        send(std::move(build), [this, state, batch](const Expected<netsnmp_pdu*>& response) mutable {
+            if (!response) {
+                for (size_t idx : batch) {
+                    state->values[idx] = unexpected(response.error());
+                }
+                readNext(state);
+                return;
+            }
+
+            long status = (*response)->errstat;
+            long index  = (*response)->errindex;
+            if (status == SNMP_ERR_TOOBIG && batch.size() > 1) {
+                // Answer does not fit into one message, ask for halves
+                auto middle = batch.begin() + long(batch.size() / 2);
+                state->batches.emplace_back(batch.begin(), middle);
+                state->batches.emplace_back(middle, batch.end());
+            } else if (status != SNMP_ERR_NOERROR && index > 0 && size_t(index) <= batch.size()) {
+                // SNMPv1 fails the whole request because of one varbind (noSuchName), ask again without it
+                state->values[batch[size_t(index - 1)]] = unexpected(snmp_errstring(int(status)));
+                batch.erase(batch.begin() + (index - 1));
+                state->batches.push_back(std::move(batch));
+            } else if (status != SNMP_ERR_NOERROR) {
+                for (size_t idx : batch) {
+                    state->values[idx] = unexpected(snmp_errstring(int(status)));
+                }
+            } else {
+                auto vars = (*response)->variables;
+                for (size_t idx : batch) {
+                    if (!vars) {
                         break;
                     }
+                    if (vars->val_len == 0) {
+                        state->values[idx] = unexpected("Wrong value type");
+                    } else {
+                        state->values[idx] = readVal(vars);
+                    }
+                    vars = vars->next_variable;
                 }
-            } else {
+            }
+            readNext(state);
+        });
+    }
+
+    /// Sends the next request of walk, every answer sends the following one until the end of the view
+    void walkNext(const std::shared_ptr<WalkState>& state)
+    {
+        // Walk starts at mib-2, but goes on to enterprise MIBs, so it is bounded by the whole internet subtree
+        static const oid root[] = {1, 3, 6, 1};
+
+        auto build = [this, state]() {
+            // SNMPv1 has no GETBULK, session can fall back to it in the middle of the walk
+            state->bulk      = state->bulk && snmp_sess_session(m_handle)->version != SNMP_VERSION_1;
+            netsnmp_pdu* pdu = snmp_pdu_create(state->bulk ? SNMP_MSG_GETBULK : SNMP_MSG_GETNEXT);
+            if (state->bulk) {
+                pdu->non_repeaters   = 0;
+                pdu->max_repetitions = state->repetitions;
+            }
+            snmp_add_null_var(pdu, state->name, state->nameLen);
+            return pdu;
+        };
+
+        send(std::move(build), [this, state](const Expected<netsnmp_pdu*>& response) {
+            if (!response || (*response)->errstat == SNMP_ERR_TOOBIG) {
+                // Answer did not fit into the message or was lost, ask for less and do not grow over it again
+                if (state->bulk && state->repetitions > 1) {
+                    state->repetitions = state->repetitions / 2;
+                    state->ceiling     = state->repetitions;
+                    walkNext(state);
+                    return;
+                }
+                state->then({});
+                return;
+            }
+            if ((*response)->errstat != SNMP_ERR_NOERROR) {
+                if (state->bulk) {
+                    // Agent which rejects GETBULK is walked by GETNEXT from the same object
+                    state->bulk = false;
+                    walkNext(state);
+                    return;
+                }
+                state->then({});
+                return;
+            }
+
+            bool done = !(*response)->variables;
+            for (auto vars = (*response)->variables; vars; vars = vars->next_variable) {
+                if (vars->type == SNMP_ENDOFMIBVIEW || vars->type == SNMP_NOSUCHOBJECT ||
+                    vars->type == SNMP_NOSUCHINSTANCE ||
+                    netsnmp_oid_is_subtree(root, OID_LENGTH(root), vars->name, vars->name_length) != 0 ||
+                    snmp_oid_compare(vars->name, vars->name_length, state->name, state->nameLen) <= 0) {
+                    // End of view, out of subtree or agent is not going forward
+                    done = true;
+                    break;
+                }
+                size_t len = std::min(vars->name_length, state->objName.size());
+                std::copy(vars->name, vars->name + len, state->objName.begin());
+                state->func({state->objName.data(), len}, readValue(vars, state->objValue));
+
+                memmove(state->name, vars->name, vars->name_length * sizeof(oid));
+                state->nameLen = vars->name_length;
+            }
+            if (done) {
+                state->then({});
+                return;
+            }
+
+            if (state->bulk && state->repetitions < state->ceiling) {
+                state->repetitions = std::min(state->repetitions * 2, state->ceiling);
+            }
+            walkNext(state);
+        });
+    }
+
+    /// Builds and sends pdu in reactor thread, callback is called from reactor thread with response (or error)
+    void send(PduBuilder&& build, Callback&& callback)
+    {
+        auto req = new Request{this, std::move(build), std::move(callback)};
+        Engine::instance().post([this, req]() {
+            if (!m_handle) {
+                finish(req, unexpected("Session closed"));
+                return;
+            }
+            m_pending.insert(req);
+            transmit(req);
+        });
+    }
+
+    /// Builds and sends pending request, reactor thread only
+    void transmit(Request* req)
+    {
+        netsnmp_pdu* pdu = req->build();
+        if (!snmp_sess_async_send(m_handle, pdu, &Impl::onResponse, req)) {
+            snmp_free_pdu(pdu);
+            finish(req, unexpected(error()));
+        }
+    }
+
+    static int onResponse(int operation, netsnmp_session* /*sess*/, int /*reqid*/, netsnmp_pdu* pdu, void* magic)
+    {
+        auto req  = static_cast<Request*>(magic);
+        auto self = req->session;
+        if (operation == NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE) {
+            if (self->m_fellBack) {
+                setV1Agent(self->m_addr);
+            }
+            self->m_probeVersion = false;
+            self->m_fellBack     = false;
+            self->finish(req, pdu);
+        } else if (self->m_probeVersion && self->m_handle) {
+            // SNMPv1 agent drops SNMPv2c messages without answer, the same request is tried by SNMPv1 once
+            log_debug("%s does not answer SNMPv2c, trying SNMPv1", self->m_addr.c_str());
+            self->m_probeVersion                       = false;
+            self->m_fellBack                           = true;
+            snmp_sess_session(self->m_handle)->version = SNMP_VERSION_1;
+            self->transmit(req);
+        } else {
+            if (self->m_fellBack && self->m_handle) {
+                // Nobody answers at all, pooled session keeps SNMPv2c
+                self->m_fellBack                           = false;
+                snmp_sess_session(self->m_handle)->version = SNMP_VERSION_2c;
+            }
+            self->finish(req, unexpected(snmp_api_errstring(SNMPERR_TIMEOUT)));
+        }
+        return 1;
+    }
+
+    void finish(Request* req, const Expected<netsnmp_pdu*>& response)
+    {
+        m_pending.erase(req);
+        req->callback(response);
+        delete req;
+    }
+
+    std::string error() const
+    {
+        int   liberr = 0;
+        int   syserr = 0;
+        char* errstr = nullptr;
+        snmp_sess_error(m_handle, &liberr, &syserr, &errstr);
+        std::string ret = errstr ? errstr : "Unknown snmp error";
+        free(errstr);
+        return ret;
+    }
+
+    Expected<std::string> value(const Expected<netsnmp_pdu*>& response)
+    {
+        if (!response) {
+            return unexpected(response.error());
+        }
+        if ((*response)->errstat != SNMP_ERR_NOERROR) {
+            return unexpected(snmp_errstring(int((*response)->errstat)));
+        }
+        if (!(*response)->variables || (*response)->variables->val_len == 0) {
+            return unexpected("Wrong value type");
+        }
+        return readVal((*response)->variables);
+    }
+
+    static Value readValue(const netsnmp_variable_list* var, std::vector<uint32_t>& buff)
+    {
+        Value val;
+        switch (var->type) {
+            case ASN_BOOLEAN:
+            case ASN_INTEGER:
+            case ASN_COUNTER:
+            case ASN_GAUGE:
+            case ASN_TIMETICKS:
+            case ASN_UINTEGER:
+                val.type    = Value::Type::Integer;
+                val.integer = var->val.integer ? int64_t(*var->val.integer) : 0;
+                break;
+            case ASN_BIT_STR:
+            case ASN_OCTET_STR:
+            case ASN_OPAQUE:
+                val.type   = Value::Type::String;
+                val.string = std::string_view(reinterpret_cast<const char*>(var->val.string), var->val_len);
+                break;
+            case ASN_IPADDRESS:
+                val.type   = Value::Type::IpAddress;
+                val.string = std::string_view(reinterpret_cast<const char*>(var->val.string), var->val_len);
+                break;
+            case ASN_OBJECT_ID: {
+                size_t len = std::min(var->val_len / sizeof(oid), buff.size());
+                std::copy(var->val.objid, var->val.objid + len, buff.begin());
+                val.type     = Value::Type::ObjectId;
+                val.objectId = {buff.data(), len};
                 break;
             }
+            case ASN_NULL:
+                val.type = Value::Type::Null;
+                break;
+            default:
+                val.type = Value::Type::Other;
         }
-        return {};
+        return val;
     }
 
-private:
     Expected<std::string> readVal(const netsnmp_variable_list* lst)
     {
         switch (lst->type) {
@@ -276,7 +1185,7 @@ private:
             case ASN_GAUGE:
             case ASN_TIMETICKS:
             case ASN_UINTEGER:
-                return convert<std::string>(int64_t(lst->val.integer));
+                return convert<std::string>(lst->val.integer ? int64_t(*lst->val.integer) : 0);
             case ASN_BIT_STR:
             case ASN_OCTET_STR:
             case ASN_OPAQUE:
@@ -292,15 +1201,19 @@ private:
 
     Expected<std::string> readObjName(const netsnmp_variable_list* lst)
     {
-        std::array<char, 255> buff;
-        snprint_objid(buff.data(), buff.size(), lst->val.objid, lst->val_len / sizeof(oid));
-        return std::string(buff.data());
+        return printOid(lst->val.objid, lst->val_len / sizeof(oid));
     }
 
 private:
-    void*           m_handle = nullptr;
-    netsnmp_session m_sess;
-    std::string     m_addr;
+    void*              m_handle = nullptr;
+    netsnmp_session    m_sess;
+    std::string        m_addr;
+    std::string        m_community;
+    std::string        m_credential; // identifies credential in pool key
+    std::string        m_key;
+    std::set<Request*> m_pending;              // accessed only from reactor thread
+    bool               m_probeVersion = false; // community session has no answer yet, reactor thread only
+    bool               m_fellBack     = false; // community session was switched to SNMPv1, reactor thread only
 };
 
 // =====================================================================================================================
@@ -312,6 +1225,8 @@ snmp::Session::Session(const std::string& addr, uint16_t port)
 {
 }
 
+snmp::Session::~Session() = default;
+
 Expected<void> snmp::Session::open()
 {
     return m_impl->open();
@@ -322,11 +1237,31 @@ Expected<std::string> snmp::Session::read(const std::string& oid) const
     return m_impl->read(oid);
 }
 
-Expected<void> snmp::Session::walk(std::function<void(const std::string&)>&& func) const
+void snmp::Session::read(const std::string& oid, ReadFunc&& then) const
+{
+    m_impl->read(oid, std::move(then));
+}
+
+std::vector<Expected<std::string>> snmp::Session::read(const std::vector<std::string>& oids) const
+{
+    return m_impl->read(oids);
+}
+
+void snmp::Session::read(const std::vector<std::string>& oids, ValuesFunc&& then) const
+{
+    m_impl->read(oids, std::move(then));
+}
+
+Expected<void> snmp::Session::walk(WalkFunc&& func) const
 {
     return m_impl->walk(std::move(func));
 }
 
+void snmp::Session::walk(WalkFunc&& func, DoneFunc&& then) const
+{
+    m_impl->walk(std::move(func), std::move(then));
+}
+
 Expected<void> snmp::Session::setCommunity(const std::string& community)
 {
     return m_impl->setCommunity(community);
@@ -363,6 +1298,18 @@ Snmp& Snmp::instance()
 
 void Snmp::init(const std::string& mibsPath)
 {
+    if (auto snap = MibSnapshot::open(mibsPath + "/" + MibSnapshot::FileName)) {
+        m_snapshot = std::move(*snap);
+        log_info("Loaded MIB snapshot with %zu symbols", m_snapshot->size());
+
+        // Names are resolved by snapshot, net-snmp does not need any MIB
+        setenv("MIBS", "", 1);
+        init_snmp("fty-discovery");
+        return;
+    } else {
+        log_warning("%s, loading all MIBs", snap.error().c_str());
+    }
+
     setenv("MIBS", "ALL", 1);
     netsnmp_get_mib_directory();
     netsnmp_set_mib_directory(mibsPath.c_str());
@@ -374,6 +1321,31 @@ void Snmp::init(const std::string& mibsPath)
     read_all_mibs();
 }
 
+const MibSnapshot* Snmp::snapshot() const
+{
+    return m_snapshot.get();
+}
+
+std::string_view Snmp::module(const snmp::OidView& oid) const
+{
+    if (m_snapshot) {
+        return m_snapshot->module(oid.data, oid.size);
+    }
+
+    // Without snapshot module is taken from printed name, names are kept, so views stay valid
+    static std::mutex            mutex;
+    static std::set<std::string> modules;
+
+    std::string name = snmp::printOid(std::vector<::oid>(oid.begin(), oid.end()).data(), oid.size);
+    size_t      pos  = name.find("::");
+    if (pos == std::string::npos) {
+        return {};
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return *modules.insert(name.substr(0, pos)).first;
+}
+
 snmp::SessionPtr Snmp::session(const std::string& address, uint16_t port)
 {
     return std::shared_ptr<snmp::Session>(new snmp::Session(address, port));
@@ -16,17 +16,68 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <fty/expected.h>
 #include <functional>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace fty::impl {
 
 namespace snmp {
     class Session;
     using SessionPtr = std::shared_ptr<Session>;
+
+    /// Timeout of one request when it is not set by @ref Session::setTimeout
+    static constexpr std::chrono::milliseconds DefaultTimeout{500};
+
+    /// Numeric object id, points to walk buffers and is valid only during the walk callback
+    struct OidView
+    {
+        const uint32_t* data = nullptr;
+        size_t          size = 0;
+
+        const uint32_t* begin() const
+        {
+            return data;
+        }
+
+        const uint32_t* end() const
+        {
+            return data + size;
+        }
+    };
+
+    /// Value of walked object, views are valid only during the walk callback
+    struct Value
+    {
+        enum class Type
+        {
+            Integer,
+            String,
+            ObjectId,
+            IpAddress,
+            Null,
+            Other
+        };
+
+        Type             type    = Type::Null;
+        int64_t          integer = 0;
+        std::string_view string; // octet string, opaque or address bytes
+        OidView          objectId;
+    };
+
+    using WalkFunc   = std::function<void(const OidView& oid, const Value& value)>;
+    using ReadFunc   = std::function<void(const Expected<std::string>& value)>;
+    using ValuesFunc = std::function<void(std::vector<Expected<std::string>>&& values)>;
+    using DoneFunc   = std::function<void(const Expected<void>& result)>;
 } // namespace snmp
 
+class MibSnapshot;
+
 // =====================================================================================================================
 
 class Snmp
@@ -38,8 +89,17 @@ public:
     snmp::SessionPtr session(const std::string& address, uint16_t port);
     void             init(const std::string& mibsPath);
 
+    /// Compiled MIB symbols, nullptr if MIB files were loaded instead
+    const MibSnapshot* snapshot() const;
+
+    /// Returns MIB module which defines object, empty if it is unknown
+    std::string_view module(const snmp::OidView& oid) const;
+
 private:
     Snmp();
+
+private:
+    std::unique_ptr<MibSnapshot> m_snapshot;
 };
 
 // =====================================================================================================================
@@ -54,11 +114,23 @@ namespace snmp {
 
         Expected<void>        open();
         Expected<std::string> read(const std::string& oid) const;
-        Expected<void>        walk(std::function<void(const std::string&)>&& func) const;
+        Expected<void>        walk(WalkFunc&& func) const;
+
+        /// Reads several OIDs by as few GET requests as possible, value or error is returned for each OID in order
+        std::vector<Expected<std::string>> read(const std::vector<std::string>& oids) const;
+
+        /// Asynchronous variants, they return immediately and the result is delivered to callback by SNMP engine
+        /// thread. Callback must not block, and the session must be kept alive by the caller until it is called.
+        void read(const std::string& oid, ReadFunc&& then) const;
+        void read(const std::vector<std::string>& oids, ValuesFunc&& then) const;
+        void walk(WalkFunc&& func, DoneFunc&& then) const;
 
     protected:
         Session(const std::string& address, uint16_t port);
 
+    public:
+        ~Session();
+
     private:
         friend class impl::Snmp;
         class Impl;
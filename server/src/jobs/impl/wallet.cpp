@@ -0,0 +1,207 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "wallet.h"
+#include "message-bus.h"
+#include "src/config.h"
+#include <fty_common_mlm_stream_client.h>
+#include <fty_common_socket_sync_client.h>
+#include <fty_log.h>
+#include <fty_security_wallet.h>
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+static constexpr const char* SecwSocket = "/run/fty-security-wallet/secw.socket";
+
+/// Compares material used to talk to devices, so a refresh which changes only metadata (name, tags) is not a change
+static bool sameSecrets(const Wallet::DocumentPtr& a, const Wallet::DocumentPtr& b)
+{
+    if (a->getType() != b->getType()) {
+        return false;
+    }
+
+    if (auto v3 = secw::Snmpv3::tryToCast(a)) {
+        auto other = secw::Snmpv3::tryToCast(b);
+        return other && v3->getSecurityLevel() == other->getSecurityLevel() &&
+               v3->getSecurityName() == other->getSecurityName() &&
+               v3->getAuthProtocol() == other->getAuthProtocol() &&
+               v3->getAuthPassword() == other->getAuthPassword() &&
+               v3->getPrivProtocol() == other->getPrivProtocol() && v3->getPrivPassword() == other->getPrivPassword();
+    }
+    if (auto v1 = secw::Snmpv1::tryToCast(a)) {
+        auto other = secw::Snmpv1::tryToCast(b);
+        return other && v1->getCommunityName() == other->getCommunityName();
+    }
+    if (auto user = secw::UserAndPassword::tryToCast(a)) {
+        auto other = secw::UserAndPassword::tryToCast(b);
+        return other && user->getUsername() == other->getUsername() && user->getPassword() == other->getPassword();
+    }
+
+    // Discovery does not derive anything from other document types
+    return true;
+}
+
+// =====================================================================================================================
+
+Wallet::Wallet() = default;
+
+Wallet::~Wallet()
+{
+    // Callbacks refer to this cache, so notifications are stopped first
+    m_notifications.reset();
+}
+
+Wallet& Wallet::instance()
+{
+    static Wallet inst;
+    return inst;
+}
+
+Expected<void> Wallet::subscribe(const std::string& actorName)
+{
+    try {
+        auto client = std::make_unique<fty::SocketSyncClient>(SecwSocket);
+        auto stream = std::make_shared<mlm::MlmStreamClient>(
+            actorName + "-secw", SECW_NOTIFICATIONS, 1000, disco::MessageBus::endpoint);
+        auto notifications = std::make_unique<secw::ConsumerAccessor>(*client, stream);
+
+        notifications->setCallbackOnUpdate([this](const std::string&, secw::DocumentPtr, secw::DocumentPtr doc) {
+            invalidate(doc->getId());
+        });
+        notifications->setCallbackOnDelete([this](const std::string&, secw::DocumentPtr doc) {
+            invalidate(doc->getId());
+        });
+        // Wallet was restarted, any document could be changed meanwhile
+        notifications->setCallbackOnStart([this]() {
+            clear();
+        });
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_client        = std::move(client);
+        m_stream        = std::move(stream);
+        m_notifications = std::move(notifications);
+        return {};
+    } catch (const std::exception& err) {
+        return unexpected(err.what());
+    }
+}
+
+Expected<Wallet::DocumentPtr> Wallet::fetch(const std::string& id)
+{
+    try {
+        fty::SocketSyncClient secwSyncClient(SecwSocket);
+        auto                  client = secw::ConsumerAccessor(secwSyncClient);
+        return client.getDocumentWithPrivateData("default", id);
+    } catch (const secw::SecwException& err) {
+        return unexpected(err.what());
+    } catch (const std::runtime_error& err) {
+        return unexpected(err.what());
+    }
+}
+
+Expected<Wallet::DocumentPtr> Wallet::document(const std::string& id)
+{
+    std::promise<DocumentPtr> promise;
+    DocumentPtr               old;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        auto it = m_docs.find(id);
+        if (it != m_docs.end() && it->second.expire > std::chrono::steady_clock::now()) {
+            return it->second.doc;
+        }
+
+        if (auto running = m_fetches.find(id); running != m_fetches.end()) {
+            // Concurrent jobs with the same credential wait for one round trip
+            auto result = running->second.result;
+            lock.unlock();
+            try {
+                return result.get();
+            } catch (const std::runtime_error& err) {
+                return unexpected(err.what());
+            }
+        }
+
+        if (it != m_docs.end()) {
+            old = it->second.doc;
+        }
+        m_fetches[id] = {promise.get_future().share()};
+    }
+
+    // Round trip is done without lock, so jobs with other credentials are not blocked by it
+    auto doc = fetch(id);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto running = m_fetches.find(id);
+        bool stale   = running->second.stale;
+        m_fetches.erase(running);
+
+        if (doc && !stale) {
+            auto ttl   = std::chrono::seconds(Config::instance().walletCacheTtl);
+            m_docs[id] = {*doc, std::chrono::steady_clock::now() + ttl};
+        } else {
+            m_docs.erase(id);
+        }
+    }
+
+    if (!doc) {
+        promise.set_exception(std::make_exception_ptr(std::runtime_error(doc.error())));
+        return unexpected(doc.error());
+    }
+    promise.set_value(*doc);
+
+    if (old && !sameSecrets(old, *doc)) {
+        log_debug("Credential %s was changed in wallet", id.c_str());
+        changed(id);
+    }
+    return doc;
+}
+
+void Wallet::invalidate(const std::string& id)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_docs.erase(id);
+        if (auto running = m_fetches.find(id); running != m_fetches.end()) {
+            running->second.stale = true;
+        }
+    }
+    log_debug("Credential %s was invalidated", id.c_str());
+    changed(id);
+}
+
+void Wallet::clear()
+{
+    std::map<std::string, Entry> docs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(docs, m_docs);
+        for (auto& it : m_fetches) {
+            it.second.stale = true;
+        }
+    }
+    for (const auto& it : docs) {
+        changed(it.first);
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::impl
@@ -0,0 +1,99 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <chrono>
+#include <fty/event.h>
+#include <fty/expected.h>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace secw {
+class Document;
+class ConsumerAccessor;
+} // namespace secw
+
+namespace mlm {
+class MlmStreamClient;
+} // namespace mlm
+
+namespace fty {
+class SocketSyncClient;
+} // namespace fty
+
+namespace fty::impl {
+
+// =====================================================================================================================
+
+/// Credentials cache in front of security wallet.
+/// Documents are fetched with private data once and shared by all jobs until they expire, so a scan of many devices
+/// with the same credential does a single wallet round trip. Documents updated or deleted in wallet are dropped as soon
+/// as wallet notifies about it.
+class Wallet
+{
+public:
+    using DocumentPtr = std::shared_ptr<secw::Document>;
+
+    static Wallet& instance();
+
+    /// Subscribes to wallet notifications
+    Expected<void> subscribe(const std::string& actorName);
+
+    /// Returns wallet document with private data
+    Expected<DocumentPtr> document(const std::string& id);
+
+    /// Forgets document, next request will fetch it again from wallet
+    void invalidate(const std::string& id);
+
+    /// Forgets all documents
+    void clear();
+
+    /// Emitted when document was invalidated or its secrets changed, holders of material derived from it should drop it
+    Event<const std::string&> changed;
+
+private:
+    Wallet();
+    ~Wallet();
+
+    struct Entry
+    {
+        DocumentPtr                           doc;
+        std::chrono::steady_clock::time_point expire;
+    };
+
+    struct Fetch
+    {
+        std::shared_future<DocumentPtr> result;
+        bool                            stale = false; // invalidated during the round trip, result is not cached
+    };
+
+    static Expected<DocumentPtr> fetch(const std::string& id);
+
+    std::mutex                   m_mutex;
+    std::map<std::string, Entry> m_docs;
+    std::map<std::string, Fetch> m_fetches; // running wallet round trips
+
+    std::unique_ptr<fty::SocketSyncClient>  m_client;
+    std::shared_ptr<mlm::MlmStreamClient>   m_stream;
+    std::unique_ptr<secw::ConsumerAccessor> m_notifications;
+};
+
+// =====================================================================================================================
+
+} // namespace fty::impl
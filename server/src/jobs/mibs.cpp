@@ -17,7 +17,11 @@
 #include "mibs.h"
 #include "impl/mibs.h"
 #include "impl/ping.h"
+#include "impl/result-cache.h"
+#include "impl/snmp.h"
+#include <atomic>
 #include <fty/string-utils.h>
+#include <map>
 #include <set>
 
 
@@ -25,72 +29,99 @@ namespace fty::job {
 
 // =====================================================================================================================
 
+static size_t mibPriority(const std::string& mib)
+{
+    // clang-format off
+    static const std::map<std::string, size_t> snmpMibPriority = {
+        {"XUPS-MIB",        0},
+        {"MG-SNMP-UPS-MIB", 1}
+    };
+    // clang-format on
+
+    auto it = snmpMibPriority.find(mib);
+    return it != snmpMibPriority.end() ? it->second : snmpMibPriority.size();
+}
+
 static bool sortMibs(const std::string& l, const std::string& r)
 {
-    try {
-        // clang-format off
-        static const std::vector<std::regex> snmpMibPriority = {
-            std::regex("XUPS-MIB"),
-            std::regex("MG-SNMP-UPS-MIB"),
-            std::regex(".+")
-        };
-        // clang-format on
-
-        auto index = [&](const std::string& mib) -> size_t {
-            for (size_t i = 0; i < snmpMibPriority.size(); ++i) {
-                if (std::regex_match(mib, snmpMibPriority[i])) {
-                    return i;
-                }
-            }
-            return 999;
-        };
-
-        return index(l) < index(r);
-    } catch (...) {
-        return false;
-    }
+    return mibPriority(l) < mibPriority(r);
 }
 
 // =====================================================================================================================
 
-void Mibs::run(const commands::mibs::In& in, commands::mibs::Out& out)
+void Mibs::run(const commands::mibs::In& in, Reply<commands::mibs::Out> reply)
 {
+    auto& cache = impl::ResultCache::instance();
+    if (commands::mibs::Out out; cache.get(commands::mibs::Subject, in, out)) {
+        log_info("Return cached mibs for %s", in.address.value().c_str());
+        reply(out);
+        return;
+    }
+
     if (!available(in.address)) {
         throw Error("Host is not available: {}", in.address.value());
     }
 
-    impl::MibsReader reader(in.address, uint16_t(in.port.value()));
+    auto reader = std::make_shared<impl::MibsReader>(in.address, uint16_t(in.port.value()));
 
     if (in.credentialId.hasValue()) {
-        if (auto res = reader.setCredentialId(in.credentialId); !res) {
+        if (auto res = reader->setCredentialId(in.credentialId); !res) {
             throw Error(res.error());
         }
     } else if (in.community.hasValue()) {
-        if (auto res = reader.setCommunity(in.community); !res) {
+        if (auto res = reader->setCommunity(in.community); !res) {
             throw Error(res.error());
         }
     } else {
         throw Error("Credential or community must be set");
     }
 
-    if (in.timeout.hasValue()) {
-        reader.setTimeout(in.timeout);
-    }
-
-    std::string assetName;
-    if (auto name = reader.readName()) {
-        assetName = *name;
-    } else {
-        throw Error("Host is not available or SNMP is not supported. SNMP error: {}", name.error());
-    }
+    // Request without timeout keeps SNMP default, not the longer default of the field
+    auto timeout = in.timeout.hasValue() ? std::chrono::milliseconds(in.timeout.value()) : impl::snmp::DefaultTimeout;
+    reader->setTimeout(uint32_t(budget(timeout).count()));
+
+    // Name and mibs are requested in parallel, the last answer replies
+    struct State
+    {
+        Expected<std::string>               name = unexpected("No answer");
+        Expected<impl::MibsReader::MibList> mibs = unexpected("No answer");
+        std::atomic<int>                    left = 2;
+    };
+    auto state = std::make_shared<State>();
+
+    auto finish = [state, in, reply]() {
+        if (!state->name) {
+            reply.fail(
+                formatString("Host is not available or SNMP is not supported. SNMP error: {}", state->name.error()));
+            return;
+        }
+        if (!state->mibs) {
+            reply.fail(
+                formatString("Host is not available or SNMP is not supported. SNMP error: {}", state->mibs.error()));
+            return;
+        }
 
-    if (auto mibs = reader.read()) {
-        out.setValue(std::vector<std::string>(mibs->begin(), mibs->end()));
+        commands::mibs::Out out;
+        out.setValue(std::vector<std::string>(state->mibs->begin(), state->mibs->end()));
         out.sort(sortMibs);
-        log_info("Configure: '%s' mibs: [%s]", assetName.c_str(), implode(out, ", ").c_str());
-    } else {
-        throw Error("Host is not available or SNMP is not supported. SNMP error: {}", mibs.error());
-    }
+        log_info("Configure: '%s' mibs: [%s]", state->name->c_str(), implode(out, ", ").c_str());
+        impl::ResultCache::instance().put(commands::mibs::Subject, in, out);
+        reply(out);
+    };
+
+    // Callbacks keep the reader (and its session) alive until both answers come
+    reader->readName([reader, state, finish](const Expected<std::string>& name) {
+        state->name = name;
+        if (--state->left == 0) {
+            finish();
+        }
+    });
+    reader->read([reader, state, finish](Expected<impl::MibsReader::MibList>&& mibs) {
+        state->mibs = std::move(mibs);
+        if (--state->left == 0) {
+            finish();
+        }
+    });
 }
 
 // =====================================================================================================================
@@ -23,13 +23,14 @@ namespace fty::job {
 
 /// Discover supported SNMP mibs
 /// Returns @ref commands::mibs::Out (list of mibs)
-class Mibs : public Task<Mibs, commands::mibs::In, commands::mibs::Out>
+/// Job only sends requests, answers are handled by SNMP engine thread, so the worker is not blocked by the device
+class Mibs : public AsyncTask<Mibs, commands::mibs::In, commands::mibs::Out>
 {
 public:
-    using Task::Task;
+    using AsyncTask::AsyncTask;
 
-    /// Runs discover job.
-    void run(const commands::mibs::In& in, commands::mibs::Out& out);
+    /// Starts discover job.
+    void run(const commands::mibs::In& in, Reply<commands::mibs::Out> reply);
 };
 
 } // namespace fty::job
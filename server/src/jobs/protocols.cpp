@@ -17,13 +17,15 @@
 #include "protocols.h"
 #include "impl/mibs.h"
 #include "impl/ping.h"
+#include "impl/result-cache.h"
 #include "impl/xml-pdc.h"
+#include "src/config.h"
+#include "src/scheduler.h"
+#include <atomic>
+#include <chrono>
 #include <fty/string-utils.h>
-#include <netdb.h>
-#include <netinet/ip_icmp.h>
-#include <poll.h>
-#include <set>
-#include <unistd.h>
+#include <future>
+#include <mutex>
 #include <yaml-cpp/yaml.h>
 
 namespace fty::job {
@@ -58,8 +60,103 @@ inline std::ostream& operator<<(std::ostream& ss, Type type)
 
 // =====================================================================================================================
 
+/// Time budget shared by all probes of one detection
+struct Budget
+{
+    using Clock = std::chrono::steady_clock;
+
+    explicit Budget(std::chrono::milliseconds timeout)
+        : deadline(Clock::now() + timeout)
+    {
+    }
+
+    /// Remaining time in seconds, rounded up (neon works with seconds)
+    uint16_t seconds() const
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        return uint16_t(std::max<long>(1, (left + 999) / 1000));
+    }
+
+    /// Remaining time in milliseconds
+    int milliseconds() const
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        return int(std::max<long>(0, left));
+    }
+
+    bool expired() const
+    {
+        return cancelled || Clock::now() >= deadline;
+    }
+
+    Clock::time_point deadline;
+    std::atomic_bool  cancelled = false;
+};
+
+static constexpr const char* ProbeQueue = "probe";
+
+/// Pool of protocol probes of all detections (requests and scans)
+static Scheduler& probes()
+{
+    static Scheduler      inst;
+    static std::once_flag once;
+    std::call_once(once, []() {
+        uint32_t threads = std::max(1u, Config::instance().probeThreads.value());
+        inst.addQueue(ProbeQueue, {1, threads, Config::instance().probeQueue.value()});
+        inst.start(threads);
+    });
+    return inst;
+}
+
+/// Runs probe on the probe pool. Probe which did not start before the deadline is not run at all, running one is
+/// bounded by the budget given to its socket timeouts, so an abandoned probe cannot hold a thread for long.
+template <typename Func>
+static std::future<Expected<void>> launch(Func&& func, const Budget& budget)
+{
+    auto promise = std::make_shared<std::promise<Expected<void>>>();
+    auto future  = promise->get_future();
+
+    Scheduler::Job job;
+    job.run = [promise, func = std::forward<Func>(func)]() {
+        try {
+            promise->set_value(func());
+        } catch (const std::exception& err) {
+            promise->set_value(unexpected(err.what()));
+        }
+    };
+    job.expired = [promise]() {
+        promise->set_value(unexpected("timeout"));
+    };
+    job.deadline = budget.deadline;
+
+    if (auto res = probes().push(ProbeQueue, std::move(job)); !res) {
+        promise->set_value(unexpected(res.error()));
+    }
+    return future;
+}
+
+// =====================================================================================================================
 
 void Protocols::run(const commands::protocols::In& in, commands::protocols::Out& out)
+{
+    auto& cache = impl::ResultCache::instance();
+    if (cache.get(commands::protocols::Subject, in, out)) {
+        log_info("Return cached result for %s", in.address.value().c_str());
+        return;
+    }
+
+    // Probes must not outlive the requester
+    commands::protocols::In request = in;
+    request.timeout                 = uint32_t(budget(std::chrono::milliseconds(in.timeout.value())).count());
+
+    detect(request, out);
+    cache.put(commands::protocols::Subject, in, out);
+
+    std::string resp = *pack::json::serialize(out);
+    log_info("Return %s", resp.c_str());
+}
+
+void Protocols::detect(const commands::protocols::In& in, commands::protocols::Out& out)
 {
     if (in.address == "__fake__") {
         out.setValue({"nut_snmp", "nut_xml_pdc"});
@@ -70,28 +167,45 @@ void Protocols::run(const commands::protocols::In& in, commands::protocols::Out&
         throw Error("Host is not available: {}", in.address.value());
     }
 
+    // All probes run in parallel, outstanding ones are cancelled once the budget is over
+    auto budget = std::make_shared<Budget>(std::chrono::milliseconds(in.timeout.value()));
+
+    auto xml = launch(
+        [in, budget]() {
+            return tryXmlPdc(in, *budget);
+        },
+        *budget);
+    auto snmp = launch(
+        [in, budget]() {
+            return trySnmp(in, *budget);
+        },
+        *budget);
+    auto powercom = launch(
+        [in, budget]() {
+            return tryPowercom(in, *budget);
+        },
+        *budget);
+
     std::vector<Type> protocols;
 
-    if (auto res = tryXmlPdc(in)) {
-        protocols.emplace_back(Type::Xml);
-        log_info("Found XML device");
-    } else {
-        log_info("Skipped xml_pdc, reason: %s", res.error().c_str());
-    }
+    auto collect = [&](std::future<Expected<void>>& probe, Type type, const char* found, const char* skipped) {
+        if (probe.wait_until(budget->deadline) != std::future_status::ready) {
+            log_info("Skipped %s, reason: timeout", skipped);
+            return;
+        }
+        if (auto res = probe.get()) {
+            protocols.emplace_back(type);
+            log_info("Found %s device", found);
+        } else {
+            log_info("Skipped %s, reason: %s", skipped, res.error().c_str());
+        }
+    };
 
-    if (auto res = trySnmp(in)) {
-        protocols.emplace_back(Type::Snmp);
-        log_info("Found SNMP device");
-    } else {
-        log_info("Skipped snmp, reason: %s", res.error().c_str());
-    }
+    collect(xml, Type::Xml, "XML", "xml_pdc");
+    collect(snmp, Type::Snmp, "SNMP", "snmp");
+    collect(powercom, Type::Powercom, "Powercom", "GenApi");
 
-    if (auto res = tryPowercom(in)) {
-        protocols.emplace_back(Type::Powercom);
-        log_info("Found Powercon device");
-    } else {
-        log_info("Skipped GenApi, reason: %s", res.error().c_str());
-    }
+    budget->cancelled = true;
 
     sortProtocols(protocols);
 
@@ -108,13 +222,11 @@ void Protocols::run(const commands::protocols::In& in, commands::protocols::Out&
                 break;
         }
     }
-    std::string resp = *pack::json::serialize(out);
-    log_info("Return %s", resp.c_str());
 }
 
-Expected<void> Protocols::tryXmlPdc(const commands::protocols::In& in) const
+Expected<void> Protocols::tryXmlPdc(const commands::protocols::In& in, const Budget& budget)
 {
-    impl::XmlPdc xml(in.address);
+    impl::XmlPdc xml(in.address, budget.seconds());
     if (auto prod = xml.get<impl::ProductInfo>("product.xml")) {
         if(!(prod->name == "Network Management Card" || prod->name == "HPE UPS Network Module")) {
             return unexpected("unsupported card type");
@@ -124,6 +236,10 @@ Expected<void> Protocols::tryXmlPdc(const commands::protocols::In& in) const
             return unexpected("unsupported XML.V4");
         }
 
+        if (budget.expired()) {
+            return unexpected("cancelled");
+        }
+
         if (auto props = xml.get<impl::Properties>(prod->summary.summary.url)) {
             return {};
         } else {
@@ -134,9 +250,9 @@ Expected<void> Protocols::tryXmlPdc(const commands::protocols::In& in) const
     }
 }
 
-Expected<void> Protocols::tryPowercom(const commands::protocols::In& in) const
+Expected<void> Protocols::tryPowercom(const commands::protocols::In& in, const Budget& budget)
 {
-    neon::Neon ne(in.address);
+    neon::Neon ne(in.address, 80, budget.seconds());
     if (auto content = ne.get("etn/v1/comm/services/powerdistributions1")) {
         try {
             YAML::Node node = YAML::Load(*content);
@@ -158,91 +274,10 @@ Expected<void> Protocols::tryPowercom(const commands::protocols::In& in) const
     }
 }
 
-static Expected<void> timeoutConnect(int sock, const struct sockaddr* name, socklen_t namelen)
-{
-    pollfd    pfd;
-    socklen_t optlen;
-    int       optval;
-    int       ret;
-
-    if ((ret = connect(sock, name, namelen)) != 0 && errno == EINPROGRESS) {
-        pfd.fd     = sock;
-        pfd.events = POLLOUT;
-        ret        = poll(&pfd, 1, 1000);
-        if (ret == 1) {
-            optlen = sizeof(optval);
-            if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &optval, &optlen) == 0) {
-                errno = optval;
-            }
-        } else if (ret == 0) {
-            errno = ETIMEDOUT;
-        } else {
-            return unexpected("poll failed");
-        }
-    }
-
-    return {};
-}
-
-struct AutoRemove
-{
-    template <typename T, typename Func>
-    AutoRemove(T& val, Func&& deleter)
-        : m_deleter([=]() {
-            deleter(val);
-        })
-    {
-    }
-
-    ~AutoRemove()
-    {
-        m_deleter();
-    }
-    std::function<void()> m_deleter;
-};
-
-Expected<void> Protocols::trySnmp(const commands::protocols::In& in) const
+Expected<void> Protocols::trySnmp(const commands::protocols::In& in, const Budget& budget)
 {
-    std::string portStr = "161";
-
-    addrinfo hints;
-    memset(&hints, 0, sizeof(addrinfo));
-
-    hints.ai_family   = AF_UNSPEC;
-    hints.ai_socktype = SOCK_DGRAM;
-    hints.ai_protocol = IPPROTO_UDP;
-
-    addrinfo* addrInfo;
-    if (int ret = getaddrinfo(in.address.value().c_str(), portStr.c_str(), &hints, &addrInfo); ret != 0) {
-        return unexpected(gai_strerror(ret));
-    }
-    AutoRemove addInfoRem(addrInfo, &freeaddrinfo);
-
-    int sock = 0;
-
-    if ((sock = socket(addrInfo->ai_family, addrInfo->ai_socktype | SOCK_NONBLOCK, addrInfo->ai_protocol)) == -1) {
-        return unexpected(strerror(errno));
-    }
-    AutoRemove sockRem(sock, &close);
-
-    if (timeoutConnect(sock, addrInfo->ai_addr, addrInfo->ai_addrlen) == 0) {
-        return unexpected(strerror(errno));
-    }
-
-    int ret = 1;
-    for (int i = 0; i <= 3; i++) {
-        if (write(sock, "X", 1) == 1) {
-            ret = 1;
-        } else {
-            ret = -1;
-        }
-    }
-
-    if (ret == -1) {
-        return unexpected("cannot write");
-    }
-
-    return {};
+    return impl::snmp::tryAgent(
+        in.address, 161, in.community, std::chrono::milliseconds(budget.milliseconds()), budget.cancelled);
 }
 
 void Protocols::sortProtocols(std::vector<Type>& protocols)
@@ -23,6 +23,7 @@ namespace fty::job {
 
 /// Forward declaration
 enum class Type;
+struct Budget;
 
 /// Discover supported protocols by endpoint
 /// Returns @ref commands::protocols::Out (list of protocols)
@@ -34,15 +35,18 @@ public:
     /// Runs discover job.
     void run(const commands::protocols::In& in, commands::protocols::Out& out);
 
+    /// Detects protocols supported by endpoint (shared with range scan)
+    static void detect(const commands::protocols::In& in, commands::protocols::Out& out);
+
 private:
     /// Try out if endpoint support xml pdc protocol
-    Expected<void> tryXmlPdc(const commands::protocols::In& in) const;
+    static Expected<void> tryXmlPdc(const commands::protocols::In& in, const Budget& budget);
 
     /// Try out if endpoint support xnmp protocol
-    Expected<void> trySnmp(const commands::protocols::In& in) const;
+    static Expected<void> trySnmp(const commands::protocols::In& in, const Budget& budget);
 
     /// Try out if endpoint support genapi protocol
-    Expected<void> tryPowercom(const commands::protocols::In& in) const;
+    static Expected<void> tryPowercom(const commands::protocols::In& in, const Budget& budget);
 
     /// Sorts protocols from most useful
     static void sortProtocols(std::vector<Type>& protocols);
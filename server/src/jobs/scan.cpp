@@ -0,0 +1,145 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "scan.h"
+#include "impl/address-range.h"
+#include "impl/reachability.h"
+#include "protocols.h"
+#include "src/config.h"
+#include "src/scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <optional>
+
+namespace fty::job {
+
+// =====================================================================================================================
+
+static constexpr const char* PoolQueue = "scan";
+
+/// Pool of host probes of all scans, scan-concurrency hosts are probed at once
+static Scheduler& pool()
+{
+    static Scheduler      inst;
+    static std::once_flag once;
+    std::call_once(once, []() {
+        const auto& conf    = Config::instance();
+        uint32_t    threads = std::max(1u, conf.scanConcurrency.value());
+        inst.addQueue(PoolQueue, {1, threads, threads * std::max(1u, conf.scanJobs.value())});
+        inst.start(threads);
+    });
+    return inst;
+}
+
+// =====================================================================================================================
+
+void Scan::run(const commands::scan::In& in, commands::scan::Out& out)
+{
+    auto addresses = impl::expandRanges(in.ranges.value(), Config::instance().scanMaxHosts);
+    if (!addresses) {
+        throw Error("Wrong address range: {}", addresses.error());
+    }
+
+    // Requester can ask for fewer parallel probes, never for more than configured
+    size_t limit       = std::max<size_t>(1, Config::instance().scanConcurrency.value());
+    size_t concurrency = in.concurrency.hasValue() ? std::min<size_t>(in.concurrency.value(), limit) : limit;
+    concurrency        = std::max<size_t>(1, std::min(concurrency, addresses->size()));
+
+    log_info("Scan %zu hosts, %zu in parallel", addresses->size(), concurrency);
+
+    // Check all hosts in big batches first, probes of every host will get cached verdict
+    impl::Reachability::instance().available(*addresses);
+
+    std::vector<std::optional<commands::scan::Result>> found(addresses->size());
+    std::atomic<size_t>                                next = 0;
+
+    auto worker = [&]() {
+        for (size_t idx = next++; idx < addresses->size(); idx = next++) {
+            auto result = probe((*addresses)[idx]);
+            publish(result);
+            if (result.protocols.size()) {
+                found[idx] = result;
+            }
+        }
+    };
+
+    // Workers of all scans share one pool, so concurrent scans cannot multiply the number of threads
+    std::vector<std::future<void>> workers;
+    for (size_t i = 0; i < concurrency; ++i) {
+        auto done = std::make_shared<std::promise<void>>();
+        workers.push_back(done->get_future());
+
+        Scheduler::Job job;
+        job.run = [worker, done]() {
+            worker();
+            done->set_value();
+        };
+        if (auto res = pool().push(PoolQueue, std::move(job)); !res) {
+            log_error("Scan: %s", res.error().c_str());
+            done->set_value();
+        }
+    }
+    for (auto& th : workers) {
+        th.wait();
+    }
+    if (next < addresses->size()) {
+        // Pool was stopped or did not take any worker
+        throw Error("Scan was interrupted");
+    }
+
+    for (const auto& result : found) {
+        if (result) {
+            out.append() = *result;
+        }
+    }
+}
+
+commands::scan::Result Scan::probe(const std::string& address) const
+{
+    commands::scan::Result result;
+    result.address = address;
+
+    commands::protocols::In  in;
+    commands::protocols::Out protocols;
+    in.address = address;
+    try {
+        Protocols::detect(in, protocols);
+        result.protocols = protocols;
+    } catch (const std::exception& err) {
+        result.error = err.what();
+    }
+    return result;
+}
+
+void Scan::publish(const commands::scan::Result& result)
+{
+    disco::Message msg;
+    msg.meta.subject       = commands::scan::Subject;
+    msg.meta.to            = m_in.meta.from;
+    msg.meta.correlationId = m_in.meta.correlationId;
+    msg.meta.status        = disco::Message::Status::Ok;
+    msg.userData.setString(*pack::json::serialize(result));
+
+    if (auto res = m_bus->publish(commands::scan::Topic, msg); !res) {
+        log_error("Cannot publish scan result: %s", res.error().c_str());
+    }
+}
+
+// =====================================================================================================================
+
+} // namespace fty::job
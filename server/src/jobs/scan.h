@@ -0,0 +1,44 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include "discovery-task.h"
+
+// =====================================================================================================================
+
+namespace fty::job {
+
+/// Scans address ranges for supported protocols
+/// Every probed host is published on @ref commands::scan::Topic, returns @ref commands::scan::Out
+class Scan : public Task<Scan, commands::scan::In, commands::scan::Out>
+{
+public:
+    using Task::Task;
+
+    /// Runs scan job.
+    void run(const commands::scan::In& in, commands::scan::Out& out);
+
+private:
+    /// Probes one host, never throws
+    commands::scan::Result probe(const std::string& address) const;
+
+    /// Sends host result to listeners of scan topic
+    void publish(const commands::scan::Result& result);
+};
+
+} // namespace fty::job
+
+// =====================================================================================================================
@@ -0,0 +1,168 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#include "scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <fty_log.h>
+
+namespace fty {
+
+// =====================================================================================================================
+
+Scheduler::~Scheduler()
+{
+    stop();
+}
+
+void Scheduler::addQueue(const std::string& subject, const Limits& limits)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto queue                = std::make_unique<Queue>();
+    queue->subject            = subject;
+    queue->limits.weight      = std::max(1u, limits.weight);
+    queue->limits.concurrency = std::max(1u, limits.concurrency);
+    queue->limits.depth       = limits.depth;
+    m_queues.push_back(std::move(queue));
+}
+
+void Scheduler::start(uint32_t workers)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_stop = false;
+    for (uint32_t i = 0; i < std::max(1u, workers); ++i) {
+        m_workers.emplace_back(&Scheduler::worker, this);
+    }
+}
+
+void Scheduler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        for (auto& queue : m_queues) {
+            queue->jobs.clear();
+        }
+    }
+    m_cond.notify_all();
+
+    for (auto& th : m_workers) {
+        if (th.joinable()) {
+            th.join();
+        }
+    }
+    m_workers.clear();
+}
+
+Expected<void> Scheduler::push(const std::string& subject, Job&& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = std::find_if(m_queues.begin(), m_queues.end(), [&](const auto& queue) {
+            return queue->subject == subject;
+        });
+        if (it == m_queues.end()) {
+            return unexpected("Unknown subject {}", subject);
+        }
+
+        auto& queue = **it;
+        if (queue.jobs.size() >= queue.limits.depth) {
+            return unexpected("Discovery is busy, too many {} requests", subject);
+        }
+        queue.jobs.push_back(std::move(job));
+    }
+    m_cond.notify_one();
+    return {};
+}
+
+void Scheduler::worker()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        Queue* queue = nullptr;
+        m_cond.wait(lock, [&]() {
+            return m_stop || (queue = next()) != nullptr;
+        });
+        if (m_stop) {
+            return;
+        }
+
+        Job job = std::move(queue->jobs.front());
+        queue->jobs.pop_front();
+        ++queue->running;
+        lock.unlock();
+
+        if (Clock::now() > job.deadline) {
+            log_debug("Scheduler: %s request expired in queue", queue->subject.c_str());
+            if (job.expired) {
+                job.expired();
+            }
+        } else if (job.start) {
+            auto released = std::make_shared<std::atomic_bool>(false);
+            job.start([this, queue, released]() {
+                if (!released->exchange(true)) {
+                    finish(*queue);
+                }
+            });
+            lock.lock();
+            continue;
+        } else {
+            job.run();
+        }
+
+        lock.lock();
+        --queue->running;
+        // Finished job could be the one which held back its queue
+        m_cond.notify_all();
+    }
+}
+
+void Scheduler::finish(Queue& queue)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --queue.running;
+    }
+    m_cond.notify_all();
+}
+
+Scheduler::Queue* Scheduler::next()
+{
+    // Smooth weighted round robin over the queues which have a job to run and a free slot for it
+    Queue*  best  = nullptr;
+    int64_t total = 0;
+    for (auto& queue : m_queues) {
+        if (queue->jobs.empty() || queue->running >= queue->limits.concurrency) {
+            continue;
+        }
+        queue->current += queue->limits.weight;
+        total += queue->limits.weight;
+        if (!best || queue->current > best->current) {
+            best = queue.get();
+        }
+    }
+    if (best) {
+        best->current -= total;
+    }
+    return best;
+}
+
+// =====================================================================================================================
+
+} // namespace fty
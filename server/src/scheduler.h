@@ -0,0 +1,103 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <fty/expected.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fty {
+
+// =====================================================================================================================
+
+/// Job scheduler with a bounded queue per subject.
+/// Queues are served by weighted round robin, every queue runs at most its own number of jobs at once, so a batch of
+/// slow jobs of one subject cannot occupy all the workers and starve quick requests of another one.
+/// Asynchronous job keeps its place in the limit until it calls done, not just until it returns.
+class Scheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Limits
+    {
+        uint32_t weight      = 1; // share of the workers when several queues are waiting
+        uint32_t concurrency = 1; // max number of running jobs
+        uint32_t depth       = 1; // max number of waiting jobs
+    };
+
+    /// Called by asynchronous job once its work is finished
+    using Done = std::function<void()>;
+
+    struct Job
+    {
+        std::function<void()>       run;                                 // job itself
+        std::function<void(Done&&)> start;                               // asynchronous job, used instead of run
+        std::function<void()>       expired;                             // called instead of job if it waited too long
+        Clock::time_point           deadline = Clock::time_point::max(); // time to start job before
+    };
+
+public:
+    Scheduler() = default;
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /// Adds queue of jobs of the subject, must be called before start
+    void addQueue(const std::string& subject, const Limits& limits);
+
+    /// Starts workers
+    void start(uint32_t workers);
+
+    /// Stops workers, waiting jobs are dropped
+    void stop();
+
+    /// Enqueues job, fails if subject is unknown or its queue is full
+    [[nodiscard]] Expected<void> push(const std::string& subject, Job&& job);
+
+private:
+    struct Queue
+    {
+        std::string     subject;
+        Limits          limits;
+        uint32_t        running = 0;
+        int64_t         current = 0;
+        std::deque<Job> jobs;
+    };
+
+    void   worker();
+    void   finish(Queue& queue);
+    Queue* next();
+
+private:
+    std::mutex                          m_mutex;
+    std::condition_variable             m_cond;
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread>            m_workers;
+    bool                                m_stop = false;
+};
+
+// =====================================================================================================================
+
+} // namespace fty
@@ -0,0 +1,87 @@
+/*  ====================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ====================================================================================================================
+*/
+
+/// Build time generator of MIB snapshot.
+/// Loads all MIB files by net-snmp and stores symbols used by discovery together with the roots of every module.
+///
+/// Usage: fty-mib-snapshot <mibs directory> <output file>
+
+#include "src/jobs/impl/mib-snapshot.h"
+#include "src/jobs/impl/mibs.h"
+// Config should be first
+#include <net-snmp/net-snmp-config.h>
+// Snmp stuff
+#include <net-snmp/net-snmp-includes.h>
+// Other
+#include <iostream>
+
+using fty::impl::MibSnapshot;
+
+static std::string fullName(const tree* node)
+{
+    char module[256];
+    return std::string(module_name(node->modid, module)) + "::" + node->label;
+}
+
+/// Collects nodes defined by another module than their parent, i.e. subtrees of the modules
+static void collectRoots(
+    const tree* node, const tree* parent, MibSnapshot::Oid& path, std::vector<MibSnapshot::Entry>& out)
+{
+    for (; node; node = node->next_peer) {
+        path.push_back(uint32_t(node->subid));
+        if (node->modid >= 0 && (!parent || parent->modid != node->modid)) {
+            out.push_back({path, fullName(node)});
+        }
+        collectRoots(node->child_list, node, path, out);
+        path.pop_back();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <mibs directory> <output file>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    setenv("MIBS", "ALL", 1);
+    netsnmp_set_mib_directory(argv[1]);
+    netsnmp_init_mib();
+    read_all_mibs();
+
+    // Used symbols go first, so they are printed instead of other names of the same object
+    std::vector<MibSnapshot::Entry> entries;
+    for (const auto& symbol : fty::impl::usedSymbols()) {
+        oid    name[MAX_OID_LEN];
+        size_t nameLen = MAX_OID_LEN;
+        if (!snmp_parse_oid(symbol.c_str(), name, &nameLen)) {
+            std::cerr << "Cannot resolve " << symbol << std::endl;
+            return EXIT_FAILURE;
+        }
+        entries.push_back({MibSnapshot::Oid(name, name + nameLen), symbol});
+    }
+
+    MibSnapshot::Oid path;
+    collectRoots(get_tree_head(), nullptr, path, entries);
+
+    if (auto res = MibSnapshot::write(argv[2], entries); !res) {
+        std::cerr << res.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    shutdown_mib();
+    return EXIT_SUCCESS;
+}
@@ -100,6 +100,15 @@ TEST_CASE("Assets / Test output")
             FAIL(ret.error());
         }
 
+        auto res = ret->userData.decode<fty::commands::assets::Out>();
+        REQUIRE(res);
+        if (in.settings.community.value() == "epdu.147") {
+            // Daisy chain of 4 units
+            CHECK(4 == res->size());
+        } else {
+            CHECK(1 == res->size());
+        }
+
         proc.interrupt();
         proc.wait();
     } else {
@@ -0,0 +1,36 @@
+#include "test-common.h"
+
+TEST_CASE("Cache / Invalidate")
+{
+    fty::commands::protocols::In in;
+    in.address = "127.0.0.1";
+
+    fty::disco::Message msg = Test::createMessage(fty::commands::protocols::Subject);
+    msg.userData.setString(*pack::json::serialize(in));
+    fty::Expected<fty::disco::Message> ret = Test::send(msg);
+    REQUIRE(ret);
+
+    // The same request is answered from the cache
+    ret = Test::send(msg);
+    REQUIRE(ret);
+    auto res = ret->userData.decode<fty::commands::protocols::Out>();
+    CHECK(res);
+    CHECK(0 == res->size());
+
+    fty::commands::cache::In inv;
+    inv.address = "127.0.0.1";
+
+    fty::disco::Message invMsg = Test::createMessage(fty::commands::cache::Subject);
+    invMsg.userData.setString(*pack::json::serialize(inv));
+    ret = Test::send(invMsg);
+    REQUIRE(ret);
+    auto out = ret->userData.decode<fty::commands::cache::Out>();
+    REQUIRE(out);
+    CHECK(out->removed >= 1);
+
+    ret = Test::send(invMsg);
+    REQUIRE(ret);
+    out = ret->userData.decode<fty::commands::cache::Out>();
+    REQUIRE(out);
+    CHECK(0 == out->removed);
+}
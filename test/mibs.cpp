@@ -1,5 +1,10 @@
 #include "test-common.h"
+#include "src/jobs/impl/mib-snapshot.h"
+#include <array>
+#include <arpa/inet.h>
 #include <fty/process.h>
+#include <poll.h>
+#include <unistd.h>
 
 TEST_CASE("Mibs / Empty request")
 {
@@ -124,3 +129,108 @@ TEST_CASE("Mibs / get mibs")
         FAIL(pid.error());
     }
 }
+
+/// Returns SNMP version and PDU tag of a message: SEQUENCE { INTEGER version, OCTET STRING community, PDU }
+static std::pair<int, uint8_t> messageKind(const std::string& msg)
+{
+    size_t pos = 0;
+    // Skips tag and length, returns size of the content
+    auto header = [&]() {
+        size_t len = uint8_t(msg.at(pos + 1));
+        pos += 2;
+        if (len & 0x80) {
+            size_t bytes = len & 0x7f;
+            len          = 0;
+            for (size_t i = 0; i < bytes; ++i) {
+                len = len << 8 | uint8_t(msg.at(pos++));
+            }
+        }
+        return len;
+    };
+
+    header();
+    header();
+    int version = uint8_t(msg.at(pos++));
+    pos += header();
+    return {version, uint8_t(msg.at(pos))};
+}
+
+TEST_CASE("Mibs / Community walk")
+{
+    // Agent which never answers, only records requests
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    REQUIRE(fd >= 0);
+    sockaddr_in addr     = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    REQUIRE(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    socklen_t len = sizeof(addr);
+    REQUIRE(getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+
+    std::vector<std::pair<int, uint8_t>> requests;
+
+    std::thread agent([&]() {
+        std::array<char, 1500> buff;
+        pollfd                 pfd = {fd, POLLIN, 0};
+        while (poll(&pfd, 1, 2000) > 0) {
+            if (ssize_t size = recv(fd, buff.data(), buff.size(), 0); size > 0) {
+                requests.push_back(messageKind(std::string(buff.data(), size_t(size))));
+            }
+        }
+    });
+
+    auto session = fty::impl::Snmp::instance().session("127.0.0.1", ntohs(addr.sin_port));
+    REQUIRE(session->setCommunity("public"));
+    REQUIRE(session->setTimeout(200));
+    REQUIRE(session->open());
+    session->walk([](const fty::impl::snmp::OidView&, const fty::impl::snmp::Value&) {});
+    session.reset();
+
+    agent.join();
+    close(fd);
+
+    // Walk starts by SNMPv2c GETBULK, agent which does not answer is asked by SNMPv1 GETNEXT
+    REQUIRE(requests.size() >= 2);
+    CHECK(requests.front() == std::pair<int, uint8_t>{1, 0xa5});
+    CHECK(requests.back() == std::pair<int, uint8_t>{0, 0xa1});
+}
+
+TEST_CASE("Mibs / Snapshot")
+{
+    using fty::impl::MibSnapshot;
+
+    std::string path = "mibs-test.snapshot";
+    REQUIRE(MibSnapshot::write(path, {
+        {{1, 3, 6, 1, 2, 1, 1, 2}, "RFC1213-MIB::sysObjectID"},
+        {{1, 3, 6, 1, 2, 1, 1, 2}, "SNMPv2-MIB::sysObjectID"},
+        {{1, 3, 6, 1, 4, 1, 534}, "EATON-OIDS::eaton"},
+        {{1, 3, 6, 1, 4, 1, 534, 6, 6, 7}, "EATON-EPDU-MIB::eatonEpdu"},
+    }));
+
+    auto snap = MibSnapshot::open(path);
+    REQUIRE(snap);
+    CHECK(4 == (*snap)->size());
+
+    auto oid = (*snap)->parse("SNMPv2-MIB::sysObjectID.0");
+    REQUIRE(oid);
+    CHECK(MibSnapshot::Oid{1, 3, 6, 1, 2, 1, 1, 2, 0} == *oid);
+    CHECK("RFC1213-MIB::sysObjectID.0" == (*snap)->print(*oid));
+
+    CHECK((*snap)->parse("sysObjectID.0"));
+    CHECK(MibSnapshot::Oid{1, 3, 6, 1, 2, 1} == *(*snap)->parse(".1.3.6.1.2.1"));
+    CHECK_FALSE((*snap)->parse("UNKNOWN-MIB::object.0"));
+    CHECK_FALSE((*snap)->parse("SNMPv2-MIB::sysObjectID.x"));
+
+    CHECK("EATON-EPDU-MIB::eatonEpdu" == (*snap)->print({1, 3, 6, 1, 4, 1, 534, 6, 6, 7}));
+    CHECK("EATON-OIDS::eaton.6.7" == (*snap)->print({1, 3, 6, 1, 4, 1, 534, 6, 7}));
+    CHECK(".1.3.6.1.4.1.9" == (*snap)->print({1, 3, 6, 1, 4, 1, 9}));
+
+    uint32_t outlet[]  = {1, 3, 6, 1, 4, 1, 534, 6, 6, 7, 6, 1};
+    uint32_t other[]   = {1, 3, 6, 1, 4, 1, 534, 1};
+    uint32_t unknown[] = {1, 3, 6, 1, 4, 1, 9};
+    CHECK("EATON-EPDU-MIB" == (*snap)->module(outlet, 12));
+    CHECK("EATON-OIDS" == (*snap)->module(other, 8));
+    CHECK((*snap)->module(unknown, 7).empty());
+
+    std::remove(path.c_str());
+}
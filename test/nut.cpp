@@ -0,0 +1,227 @@
+#include "src/config.h"
+#include "src/jobs/impl/nut/child-process.h"
+#include "src/jobs/impl/nut/drivers.h"
+#include "src/jobs/impl/nut/dump.h"
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <sstream>
+
+using namespace fty::impl::nut;
+
+TEST_CASE("Nut / Child process output")
+{
+    ChildProcess proc(
+        "/bin/sh", {"-c", "for i in $(seq 1 1000); do echo \"key.$i: $VALUE\"; done; echo oops >&2; exit 3"});
+    proc.setEnvVar("VALUE", "val");
+    REQUIRE(proc.start());
+
+    int  lines = 0;
+    bool same  = true;
+    auto stat  = proc.read([&](std::string_view line) {
+        ++lines;
+        same = same && line.substr(line.size() - 5) == ": val";
+        return true;
+    });
+    REQUIRE(stat);
+    CHECK(*stat == 3);
+    CHECK(lines == 1000);
+    CHECK(same);
+    CHECK(proc.errors() == "oops\n");
+}
+
+TEST_CASE("Nut / Child process is stopped")
+{
+    ChildProcess proc("/bin/sh", {"-c", "echo first: 1; echo second: 2; sleep 10; echo third: 3"});
+    REQUIRE(proc.start());
+
+    int  lines = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto stat  = proc.read([&](std::string_view line) {
+        ++lines;
+        return line.find("second") != 0;
+    });
+    REQUIRE(stat);
+    CHECK(*stat == 0);
+    CHECK(lines == 2);
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    ChildProcess slow("/bin/sh", {"-c", "sleep 10"});
+    REQUIRE(slow.start());
+    auto timeout = slow.read([](std::string_view) { return true; }, 100);
+    CHECK(!timeout);
+
+    // Output is closed, but the process goes on
+    ChildProcess silent("/bin/sh", {"-c", "exec >&- 2>&-; sleep 10"});
+    REQUIRE(silent.start());
+    start   = std::chrono::steady_clock::now();
+    timeout = silent.read([](std::string_view) { return true; }, 200);
+    CHECK(!timeout);
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    ChildProcess missing("/nonexistent/driver", {});
+    CHECK(!missing.start());
+}
+
+TEST_CASE("Nut / Child process limits")
+{
+    ChildProcess limited("/bin/sh", {"-c", "ulimit -v; ulimit -t"});
+    limited.setLimits(5, 64 * 1024 * 1024);
+    REQUIRE(limited.start());
+
+    std::vector<std::string> lines;
+    limited.read([&](std::string_view line) {
+        lines.emplace_back(line);
+        return true;
+    });
+    CHECK(lines == std::vector<std::string>{"65536", "5"});
+
+    // Process which ignores SIGTERM is killed
+    ChildProcess stubborn("/bin/sh", {"-c", "trap '' TERM; echo started; while true; do sleep 1; done"});
+    REQUIRE(stubborn.start());
+    auto start = std::chrono::steady_clock::now();
+    auto stat  = stubborn.read([](std::string_view) { return false; });
+    CHECK(stat);
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
+
+TEST_CASE("Nut / Dump")
+{
+    // Daisy chain is described before device.type, nothing after it is needed
+    Dump daisy;
+    CHECK(daisy.add("Network UPS Tools - Generic SNMP UPS driver"));
+    CHECK(daisy.add("device.1.model: EPDU MI 38U-A IN: CS16A 1P OUT: 24XC13:6XC19"));
+    CHECK(daisy.add("device.2.model: EPDU MI 38U-A IN: CS16A 1P OUT: 24XC13:6XC19"));
+    CHECK(daisy.add("device.count: 2"));
+    CHECK(daisy.add("device.type: pdu"));
+    CHECK_FALSE(daisy.add("outlet.1.current: 0"));
+    CHECK(daisy.values().size() == 5);
+    CHECK(daisy.value("device.2.model") == "EPDU MI 38U-A IN: CS16A 1P OUT: 24XC13:6XC19");
+
+    // Malformed count is not a daisy chain
+    Dump malformed;
+    CHECK(malformed.add("device.count: many"));
+    CHECK(malformed.add("device.type: pdu"));
+    CHECK(malformed.value("device.count") == "many");
+
+    // Unsorted dump is read to the end
+    Dump unsorted;
+    CHECK(unsorted.add("device.type: ups"));
+    CHECK(unsorted.add("device.mfr: EATON"));
+    CHECK(unsorted.add("zzz.last: 1"));
+
+    Dump whole;
+    whole.parse("device.mfr: EATON\ndevice.type: ups\n\nups.serial: G202E01012");
+    CHECK(whole.values().size() == 3);
+    CHECK(whole.value("ups.serial") == "G202E01012");
+    CHECK_FALSE(whole.value("ups.model"));
+
+    // Lines which are not "key: value"
+    Dump lines;
+    lines.parse("Network UPS Tools - Generic SNMP UPS driver 2.7.4\n"
+                "ups.model:no space\n"
+                "Ups.model: upper case\n"
+                ": no key\n"
+                "ups.mfr :\tEATON\n"
+                "ups.firmware:   \n"
+                "ups.mfr: repeated\n"
+                "input.voltage: 230.0 : V\n");
+    REQUIRE(lines.values().size() == 3);
+    CHECK(lines.value("ups.mfr") == "EATON");
+    CHECK(lines.value("ups.firmware") == "");
+    CHECK(lines.value("input.voltage") == "230.0 : V");
+}
+
+TEST_CASE("Nut / Dump benchmark", "[.benchmark]")
+{
+    // Daisy chain of 4 epdus with 24 outlets each, in the form snmp-ups dumps it
+    std::string content;
+    for (int dev = 1; dev <= 4; ++dev) {
+        for (auto key : {"mfr", "model", "serial", "part", "type", "contact", "location", "macaddr"}) {
+            content += "device." + std::to_string(dev) + "." + key + ": EPDU MI 38U-A IN: CS16A 1P OUT: 24XC13:6XC19\n";
+        }
+        for (int out = 1; out <= 24; ++out) {
+            for (auto key : {"current", "realpower", "status", "switchable", "desc", "id"}) {
+                content += "device." + std::to_string(dev) + ".outlet." + std::to_string(out) + "." + key + ": " +
+                           std::to_string(out * 10) + "\n";
+            }
+        }
+    }
+    content += "device.count: 4\ndevice.type: pdu\n";
+
+    using Clock = std::chrono::steady_clock;
+    const int rounds = 100;
+
+    auto   start = Clock::now();
+    size_t count = 0;
+    for (int i = 0; i < rounds; ++i) {
+        // Parsing as it was done before: regex per line into a map
+        static std::regex                  rex("([a-z0-9\\.]+)\\s*:\\s+(.*)");
+        std::map<std::string, std::string> values;
+        std::stringstream                  ss(content);
+        for (std::string line; std::getline(ss, line);) {
+            std::smatch matches;
+            if (std::regex_match(line, matches, rex)) {
+                values.emplace(matches.str(1), matches.str(2));
+            }
+        }
+        count += values.size();
+    }
+    auto regex = Clock::now() - start;
+
+    start = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        Dump dump;
+        dump.parse(content);
+        count -= dump.values().size();
+    }
+    auto tokenizer = Clock::now() - start;
+
+    CHECK(count == 0);
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    WARN("regex: " << duration_cast<microseconds>(regex).count() / rounds << " us, tokenizer: "
+                   << duration_cast<microseconds>(tokenizer).count() / rounds << " us per dump");
+    CHECK(tokenizer < regex);
+}
+
+TEST_CASE("Nut / Drivers")
+{
+    auto& drivers = Drivers::instance();
+    auto  limit   = int(fty::Config::instance().driverJobs.value());
+
+    std::vector<Drivers::Slot> slots;
+    for (int i = 0; i < limit; ++i) {
+        auto slot = drivers.acquire("test-driver", 0);
+        REQUIRE(slot);
+        CHECK(std::filesystem::is_empty(slot->stateDir()));
+        slots.push_back(std::move(*slot));
+    }
+    CHECK_FALSE(drivers.acquire("test-driver", 50));
+    CHECK(drivers.acquire("other-driver", 0));
+
+    // State directory is cleaned and reused by the next run
+    std::string stateDir = slots.back().stateDir();
+    std::ofstream(stateDir + "/test-driver.pid") << "1";
+    slots.pop_back();
+
+    auto slot = drivers.acquire("test-driver", 0);
+    REQUIRE(slot);
+    CHECK(slot->stateDir() == stateDir);
+    CHECK(std::filesystem::is_empty(stateDir));
+
+    drivers.spawned("test-driver", std::chrono::microseconds(100));
+    drivers.spawned("test-driver", std::chrono::microseconds(300));
+    auto stats = drivers.stats();
+    auto it    = std::find_if(stats.begin(), stats.end(), [](const auto& stat) {
+        return stat.driver == "test-driver";
+    });
+    REQUIRE(it != stats.end());
+    CHECK(it->running == uint32_t(limit));
+    CHECK(it->spawns == 2);
+    CHECK(it->spawnMax == std::chrono::microseconds(300));
+
+    CHECK_FALSE(drivers.path("not-a-driver"));
+}
@@ -1,4 +1,5 @@
 #include "test-common.h"
+#include "src/jobs/impl/snmp-probe.h"
 
 TEST_CASE("Protocols/ Empty request")
 {
@@ -92,6 +93,30 @@ TEST_CASE("Protocols / resolve")
     fty::Expected<fty::disco::Message> ret2 = Test::send(msg);
 }
 
+TEST_CASE("Protocols / Snmp probe encoding")
+{
+    using namespace fty::impl::snmp;
+
+    // clang-format off
+    const std::string get(
+        "\x30\x26\x02\x01\x00\x04\x06public"
+        "\xa0\x19\x02\x01\x01\x02\x01\x00\x02\x01\x00"
+        "\x30\x0e\x30\x0c\x06\x08\x2b\x06\x01\x02\x01\x01\x02\x00\x05\x00", 40);
+    // clang-format on
+    CHECK(get == probe::encodeGet(probe::Version::V1, "public", 1));
+
+    // Same message as response
+    std::string resp = probe::encodeGet(probe::Version::V2c, "public", 1234567);
+    resp[13]         = '\xa2';
+    CHECK(1234567 == probe::responseId(resp));
+
+    // Request is not an answer
+    CHECK_FALSE(probe::responseId(probe::encodeGet(probe::Version::V2c, "public", 1)));
+
+    CHECK(-42 == probe::responseId(probe::encodeDiscovery(-42)));
+    CHECK_FALSE(probe::responseId("garbage"));
+}
+
 /*TEST_CASE("Protocols / powercom")
 {
     fty::Message msg = Test::createMessage(fty::commands::protocols::Subject);
@@ -0,0 +1,58 @@
+#include "test-common.h"
+#include "src/jobs/impl/address-range.h"
+
+TEST_CASE("Scan / Empty request")
+{
+    fty::disco::Message msg = Test::createMessage(fty::commands::scan::Subject);
+
+    fty::Expected<fty::disco::Message> ret = Test::send(msg);
+    CHECK_FALSE(ret);
+    CHECK("Wrong input data: payload is empty" == ret.error());
+}
+
+TEST_CASE("Scan / Wrong range")
+{
+    fty::disco::Message msg = Test::createMessage(fty::commands::scan::Subject);
+
+    fty::commands::scan::In in;
+    in.ranges.append("10.0.0.0/33");
+    msg.userData.setString(*pack::json::serialize(in));
+
+    fty::Expected<fty::disco::Message> ret = Test::send(msg);
+    CHECK_FALSE(ret);
+    CHECK("Wrong address range: Wrong prefix length in '10.0.0.0/33'" == ret.error());
+}
+
+TEST_CASE("Scan / Not asset")
+{
+    fty::disco::Message msg = Test::createMessage(fty::commands::scan::Subject);
+
+    fty::commands::scan::In in;
+    in.ranges.append("127.0.0.1/32");
+    msg.userData.setString(*pack::json::serialize(in));
+
+    fty::Expected<fty::disco::Message> ret = Test::send(msg);
+    CHECK(ret);
+    auto res = ret->userData.decode<fty::commands::scan::Out>();
+    CHECK(res);
+    CHECK(0 == res->size());
+}
+
+TEST_CASE("Scan / Expand ranges")
+{
+    auto cidr = fty::impl::expandRanges({"10.0.0.0/30"}, 16);
+    REQUIRE(cidr);
+    CHECK(std::vector<std::string>{"10.0.0.1", "10.0.0.2"} == *cidr);
+
+    auto range = fty::impl::expandRanges({"10.0.0.254-10.0.1.1", "10.0.0.255"}, 16);
+    REQUIRE(range);
+    CHECK(std::vector<std::string>{"10.0.0.254", "10.0.0.255", "10.0.1.0", "10.0.1.1"} == *range);
+
+    auto shortRange = fty::impl::expandRanges({"10.0.0.1-3"}, 16);
+    REQUIRE(shortRange);
+    CHECK(3 == shortRange->size());
+
+    CHECK_FALSE(fty::impl::expandRanges({"10.0.0.0/8"}, 16));
+    CHECK_FALSE(fty::impl::expandRanges({"10.0.0.5-10.0.0.1"}, 16));
+    CHECK_FALSE(fty::impl::expandRanges({"pointtosky"}, 16));
+}
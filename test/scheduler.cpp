@@ -0,0 +1,115 @@
+#include "src/scheduler.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <catch2/catch.hpp>
+
+TEST_CASE("Scheduler / Limits")
+{
+    fty::Scheduler scheduler;
+    scheduler.addQueue("slow", {1, 2, 4});
+    scheduler.addQueue("fast", {8, 4, 100});
+    scheduler.start(4);
+
+    std::atomic<int> slowDone    = 0;
+    std::atomic<int> slowRunning = 0;
+    std::atomic<int> slowMax     = 0;
+    std::atomic<int> fastDone    = 0;
+    std::atomic<int> expired     = 0;
+
+    int busy = 0;
+    for (int i = 0; i < 10; ++i) {
+        fty::Scheduler::Job job;
+        job.run = [&]() {
+            int running = ++slowRunning;
+            int max     = slowMax;
+            while (running > max && !slowMax.compare_exchange_weak(max, running)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            --slowRunning;
+            ++slowDone;
+        };
+        if (!scheduler.push("slow", std::move(job))) {
+            ++busy;
+        }
+    }
+
+    for (int i = 0; i < 20; ++i) {
+        fty::Scheduler::Job job;
+        job.run = [&]() {
+            ++fastDone;
+        };
+        CHECK(scheduler.push("fast", std::move(job)));
+    }
+
+    fty::Scheduler::Job late;
+    late.run = [&]() {
+        FAIL("Expired job was started");
+    };
+    late.expired = [&]() {
+        ++expired;
+    };
+    late.deadline = fty::Scheduler::Clock::now() - std::chrono::seconds(1);
+    CHECK(scheduler.push("fast", std::move(late)));
+
+    CHECK_FALSE(scheduler.push("unknown", {}));
+
+    // Fast jobs are not waiting for the slow ones
+    for (int i = 0; i < 100 && (fastDone < 20 || !expired); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(20 == fastDone);
+    CHECK(1 == expired);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    scheduler.stop();
+
+    // 2 jobs are running, 4 are waiting, all others are rejected
+    CHECK(busy >= 4);
+    CHECK(10 - busy == slowDone);
+    CHECK(2 == slowMax);
+}
+
+TEST_CASE("Scheduler / Asynchronous jobs")
+{
+    fty::Scheduler scheduler;
+    scheduler.addQueue("async", {1, 2, 10});
+    scheduler.start(4);
+
+    std::mutex                        mutex;
+    std::vector<fty::Scheduler::Done> pending;
+    std::atomic<int>                  started = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        fty::Scheduler::Job job;
+        job.start = [&](fty::Scheduler::Done&& done) {
+            ++started;
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(std::move(done));
+        };
+        CHECK(scheduler.push("async", std::move(job)));
+    }
+
+    // Started jobs keep their slots after they return
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(2 == started);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending[0]();
+        pending[0]();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(3 == started);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& done : pending) {
+            done();
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(4 == started);
+
+    scheduler.stop();
+}